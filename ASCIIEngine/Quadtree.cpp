@@ -1,233 +1,551 @@
 #include "quadtree.h"
+#include "linear_quadtree.h"
 #include <iostream>
 
-Quadtree::Quadtree(const Rect& r) {
-	root = new Quadrant(r.lb.x, r.lb.y, r.rt.x, r.rt.y, nullptr);
+// Anonymous namespace to hide internal helper functions
+namespace {
+	Point2d centerOf(const BoundingBox& b) {
+		return Point2d(b.minX + (b.maxX - b.minX) / 2, b.minY + (b.maxY - b.minY) / 2);
+	}
 }
 
-Quadtree::~Quadtree() {
+Quadtree::Quadtree(const Rect& r, double looseness, uint32_t bucketCapacity, uint16_t maxDepth) {
+	this->looseness = max(looseness, 1.0);
+	this->bucketCapacity = max(bucketCapacity, 1u);
+	this->maxDepth = min(maxDepth, MAX_DEPTH_LIMIT);
+	quadrants.resize(1);
+	initQuadrant(ROOT, r.lb.x, r.lb.y, r.rt.x, r.rt.y, NONE);
+	// Shapes reaching outside the tree's area still have to be found, so they collect at the root
+	quadrants[ROOT].loose = BoundingBox(0, 0, UINT32_MAX, UINT32_MAX);
+}
 
-	for (const auto l : gridLines) {
-		if (l->vertices.size() > 0) {
-			delete l;
-		}
+uint32_t Quadtree::allocateChildren() {
+	if (freeQuadrants != NONE) {
+		uint32_t first = freeQuadrants;
+		freeQuadrants = quadrants[first].children;
+		return first;
 	}
-	delete root;
+	uint32_t first = (uint32_t)quadrants.size();
+	quadrants.resize(quadrants.size() + 4);
+	return first;
 }
 
-Quadtree::Quadrant::Quadrant(uint32_t left, uint32_t bottom, uint32_t right, uint32_t top, Quadrant* parent) {
-	this->left = left;
-	this->right = right;
-	this->top = top;
-	this->bottom = bottom;
-	this->parent = parent;
-	if (!parent) {
-		this->depth = 0;
+void Quadtree::releaseChildren(uint32_t first) {
+	for (uint32_t c = first; c < first + 4; c++) {
+		quadrants[c].parent = NONE;
+	}
+	quadrants[first].children = freeQuadrants;
+	freeQuadrants = first;
+}
+
+uint32_t Quadtree::allocateItem(Geometry* g) {
+	uint32_t item = freeItems;
+	if (item != NONE) {
+		freeItems = items[item].next;
 	} else {
-		this->depth = parent->depth + 1;
+		item = (uint32_t)items.size();
+		items.push_back(Item());
 	}
-	resetChildren();
-};
+	items[item].g = g;
+	items[item].next = NONE;
+	return item;
+}
 
-Quadtree::Quadrant::~Quadrant() {
+void Quadtree::releaseItem(uint32_t item) {
+	items[item].next = freeItems;
+	freeItems = item;
+}
+
+void Quadtree::initQuadrant(uint32_t q, uint32_t left, uint32_t bottom, uint32_t right, uint32_t top, uint32_t parent) {
+	Quadrant& quadrant = quadrants[q];
+	quadrant.left = left;
+	quadrant.right = right;
+	quadrant.top = top;
+	quadrant.bottom = bottom;
+	quadrant.parent = parent;
+	quadrant.depth = parent == NONE ? 0 : quadrants[parent].depth + 1;
+	quadrant.children = NONE;
+	quadrant.firstItem = NONE;
+	quadrant.itemCount = 0;
+	uint32_t marginX = (uint32_t)(quadrant.getWidth() * (looseness - 1) / 2);
+	uint32_t marginY = (uint32_t)(quadrant.getHeight() * (looseness - 1) / 2);
+	quadrant.loose = BoundingBox(left - min(left, marginX), top - min(top, marginY), right + min(UINT32_MAX - right, marginX), bottom + min(UINT32_MAX - bottom, marginY));
+}
+
+void Quadtree::assignItem(uint32_t q, uint32_t item) {
 
-	for (Quadrant* c : children) {
-		delete c;
+	// Step past any quadrant already divided, since a child divided earlier in the same push down may take the shape
+	for (uint32_t next = findChildQuadrant(q, items[item].g); next != NONE; next = findChildQuadrant(q, items[item].g)) {
+		q = next;
 	}
-	delete p;
+	// Hold the shape here while this leaf has room, or if it is too small or too deep to divide. A divided quadrant
+	// reached here fits none of its children, so it keeps the shape however many it holds
+	items[item].next = quadrants[q].firstItem;
+	quadrants[q].firstItem = item;
+	quadrants[q].itemCount++;
+	split(q);
 }
 
-void Quadtree::Quadrant::assignPoint(const Point2d& p_p, std::vector<Line*>& lines) {
-	
-	// Assign point to empty quadrant
-	if (!p) {
-		p = new Point2d(p_p);
+void Quadtree::split(uint32_t q) {
+	const Quadrant& quadrant = quadrants[q];
+	if (quadrant.itemCount <= bucketCapacity || quadrant.isParent() || quadrant.depth >= maxDepth || quadrant.getWidth() == 0 || quadrant.getHeight() == 0) {
 		return;
 	}
-	// If p already exists, divide this quadrant into 4 subsections
-	segmentQuadrant(lines);
+	// Otherwise divide this quadrant into 4 subsections
+	segmentQuadrant(q);
 
-	// Look for the appropriate quadrant to re-assign p
-	// Recursively assign p_p until it lands in a quadrant that is empty
-	int index_p_p = -1;
-	for (int i = 0; i < 4; i++) {
-		if (p && children.at(i)->collidesWith(*p)) {
-			children.at(i)->p = p;
-			this->p = nullptr;
+	// Push down every shape that fits a child, recursively splitting any child that overflows in turn. The list
+	// nodes move with their shapes rather than being reallocated
+	uint32_t held = quadrants[q].firstItem;
+	quadrants[q].firstItem = NONE;
+	quadrants[q].itemCount = 0;
+	while (held != NONE) {
+		uint32_t next = items[held].next;
+		uint32_t child = findChildQuadrant(q, items[held].g);
+		if (child != NONE) {
+			assignItem(child, held);
+		} else {
+			items[held].next = quadrants[q].firstItem;
+			quadrants[q].firstItem = held;
+			quadrants[q].itemCount++;
 		}
-		if (children.at(i)->collidesWith(p_p))
-			index_p_p = i;
+		held = next;
 	}
-	if (index_p_p != -1) {
-		children.at(index_p_p)->assignPoint(p_p, lines);
+}
+
+void Quadtree::collapse(uint32_t q) {
+	uint32_t first = quadrants[q].children;
+	if (first == NONE) {
 		return;
 	}
-
-	Debug::DebugMessage msg = Debug::DebugMessage(CallingClasses::QUADTREE_CLASS, DebugTypes::QUADRANT_NOT_FOUND);
-	msg.Print();
+	for (uint32_t c = first; c < first + 4; c++) {
+		collapse(c);
+		// Splice the child's list onto the front of this quadrant's
+		uint32_t item = quadrants[c].firstItem;
+		while (item != NONE) {
+			uint32_t next = items[item].next;
+			items[item].next = quadrants[q].firstItem;
+			quadrants[q].firstItem = item;
+			item = next;
+		}
+		quadrants[q].itemCount += quadrants[c].itemCount;
+	}
+	quadrants[q].children = NONE;
+	releaseChildren(first);
+	version++;
 }
 
-uint16_t Quadtree::Quadrant::sumValidPointsRemaining() {
-	uint16_t count = 0;
-	if (p) {
-		count++;
+uint32_t Quadtree::sumValidItemsRemaining(uint32_t q) {
+	uint32_t count = min(quadrants[q].itemCount, bucketCapacity + 1);
+	if (!quadrants[q].isParent()) {
+		return count;
 	}
-	for (Quadrant* q : children) {
-		count += q->sumValidPointsRemaining();
-		if (count > 1) {
-			// return early if enough points are found
+	for (uint32_t c = quadrants[q].children; c < quadrants[q].children + 4; c++) {
+		count += sumValidItemsRemaining(c);
+		if (count > bucketCapacity) {
+			// return early if enough items are found
 			return count;
 		}
 	}
 	return count;
 }
 
-bool Quadtree::Quadrant::linesEligibleForRemoval() {
-	return sumValidPointsRemaining() < 2;
+bool Quadtree::linesEligibleForRemoval(uint32_t q) {
+	return sumValidItemsRemaining(q) <= bucketCapacity;
 }
 
-void Quadtree::Quadrant::segmentQuadrant(std::vector<Line*>& lines) {
-	uint32_t halfWidthIndex = getWidth() / 2;
-	uint32_t halfHeightIndex = getHeight() / 2;
+void Quadtree::segmentQuadrant(uint32_t q) {
+	// Allocating may move the pool, so the parent is copied first
+	uint32_t first = allocateChildren();
+	Quadrant parent = quadrants[q];
+	uint32_t halfWidthIndex = parent.getWidth() / 2;
+	uint32_t halfHeightIndex = parent.getHeight() / 2;
 
 	// Adjust for odd number dimensions
-	if (getWidth() % 2 == 0)
+	if (parent.getWidth() % 2 == 0)
 		halfWidthIndex--;
-	if (getHeight() % 2 == 0)
+	if (parent.getHeight() % 2 == 0)
 		halfHeightIndex--;
 
-	// Store the crossed gridlines each time we identify a new quadrant to segment (since the lines are 1 pixel apart for each quad, we include
-	// all four lines required to draw the cross pattern)
-	// Vertical left of center
-	Line* verticalLeftOfCenter = new Line(Point2d(left + halfWidthIndex, top), Point2d(left + halfWidthIndex, bottom));
-	lines.push_back(verticalLeftOfCenter);
-	quadrantLines.push_back(verticalLeftOfCenter);
-	// Right of center
-	Line* verticalRightOfCenter = new Line(Point2d(left + halfWidthIndex + 1, top), Point2d(left + halfWidthIndex + 1, bottom));
-	lines.push_back(verticalRightOfCenter);
-	quadrantLines.push_back(verticalRightOfCenter);
-	// Horizontal top of center
-	Line* horizontalTopOfCenter = new Line(Point2d(left, bottom - halfHeightIndex - 1), Point2d(right, bottom - halfHeightIndex - 1));
-	lines.push_back(horizontalTopOfCenter);
-	quadrantLines.push_back(horizontalTopOfCenter);
-	// Bottom of center
-	Line* horizontalBottomOfCenter = new Line(Point2d(left, bottom - halfHeightIndex), Point2d(right, bottom - halfHeightIndex));
-	lines.push_back(horizontalBottomOfCenter);
-	quadrantLines.push_back(horizontalBottomOfCenter);
-
-	// Seqment current quad into 4 children
-	Quadrant* bottomLeft = new Quadrant(left, bottom, left + halfWidthIndex, bottom - halfHeightIndex, this);
-	children.push_back(bottomLeft);
-	Quadrant* topLeft = new Quadrant(left, bottom - halfHeightIndex - 1, left + halfWidthIndex, top, this);
-	children.push_back(topLeft);
-	Quadrant* topRight = new Quadrant(left + halfWidthIndex + 1, bottom - halfHeightIndex - 1, right, top, this);
-	children.push_back(topRight);
-	Quadrant* bottomRight = new Quadrant(left + halfWidthIndex + 1, bottom, right, bottom - halfHeightIndex, this);
-	children.push_back(bottomRight);
-}
-
-Quadtree::Quadrant* Quadtree::Quadrant::findChildQuadrant(const Point2d& p_p) {
-	bool right = false, top = false;
-	if (p_p.x >= children.at(3)->left) {
-		right = true;
-	}
-	if (p_p.y <= children.at(2)->bottom) {
-		top = true;
-	}
-	// enforces natural binary conversion from a two bit binary integer back to indices for children
-	int mask = 0b00;
-	mask |= (int)right << 1;
-	right ? mask |= (int)!top << 0 : mask |= (int)top << 0;
-	return children.at(mask);
+	// Seqment current quad into 4 children, stored together in the same order as before
+	initQuadrant(first, parent.left, parent.bottom, parent.left + halfWidthIndex, parent.bottom - halfHeightIndex, q);
+	initQuadrant(first + 1, parent.left, parent.bottom - halfHeightIndex - 1, parent.left + halfWidthIndex, parent.top, q);
+	initQuadrant(first + 2, parent.left + halfWidthIndex + 1, parent.bottom - halfHeightIndex - 1, parent.right, parent.top, q);
+	initQuadrant(first + 3, parent.left + halfWidthIndex + 1, parent.bottom, parent.right, parent.bottom - halfHeightIndex, q);
+	quadrants[q].splitX = parent.left + halfWidthIndex + 1;
+	quadrants[q].splitY = parent.bottom - halfHeightIndex - 1;
+	quadrants[q].children = first;
+	version++;
 }
 
-void Quadtree::addGeometry(Geometry* g) {
-	for (Point2d p : g->vertices) {
-		assignPoint(p);
+uint32_t Quadtree::findChildQuadrant(uint32_t q, const Point2d& p_p) const {
+	// Children run clockwise from the bottom left, so the right half is 2 and 3 and the low bit flips between its halves
+	const Quadrant& quadrant = quadrants[q];
+	uint32_t right = p_p.x >= quadrant.splitX;
+	uint32_t top = p_p.y <= quadrant.splitY;
+	return quadrant.children + ((right << 1) | (right ^ top));
+}
+
+uint32_t Quadtree::findChildQuadrant(uint32_t q, Geometry* g) const {
+	if (!quadrants[q].isParent()) {
+		return NONE;
 	}
+	uint32_t child = findChildQuadrant(q, centerOf(g->bounds));
+	return quadrants[child].loose.contains(g->bounds) ? child : NONE;
+}
+
+void Quadtree::addGeometry(Geometry* g) {
+	// Step down through every quadrant whose child can take the shape, then hold it at the first that cannot
+	assignItem(findQuadrant(g), allocateItem(g));
+}
+
+void Quadtree::addGeometry(const std::vector<Geometry*>& geometry) {
+	update(geometry, std::vector<Geometry*>());
 }
 
 void Quadtree::removeGeometry(Geometry* g) {
-	
-	// Insert the parent of each point of the geometry into a set, enforcing uniqueness and sorted by descending depth
-	std::set<Quadrant*, Quadtree::byDepth> parentsOfRemoved;
-	for (Point2d p : g->vertices) {
-		Quadrant* parentOfRemoved = unassignPoint(p);
-		
-		parentsOfRemoved.insert(parentOfRemoved);
-	}
-
-	// Now that all vertices are removed, can we remove this quadrant, its siblings, and the gridlines?
-	while (!parentsOfRemoved.empty()) {
-		auto it = next(parentsOfRemoved.begin(), 0);
-		Quadrant* parentOfRemoved = *it;
-		if (parentOfRemoved->linesEligibleForRemoval()) {
-			for (Line* l : parentOfRemoved->quadrantLines) {
-				delete l;
-				gridLines.pop_back();
+
+	uint32_t holder = unlinkItem(g);
+	if (holder == NONE) {
+		return;
+	}
+
+	// Can we now return this quadrant's parent's children to the pool, and so on upwards?
+	uint32_t parentOfRemoved = quadrants[holder].isParent() ? holder : quadrants[holder].parent;
+	while (parentOfRemoved != NONE && linesEligibleForRemoval(parentOfRemoved)) {
+		collapse(parentOfRemoved);
+		parentOfRemoved = quadrants[parentOfRemoved].parent;
+	}
+}
+
+void Quadtree::removeGeometry(const std::vector<Geometry*>& geometry) {
+	update(std::vector<Geometry*>(), geometry);
+}
+
+void Quadtree::update(const std::vector<Geometry*>& added, const std::vector<Geometry*>& removed) {
+	// Apply every change to the quadrants as they stand, neither splitting nor collapsing, and note where each landed.
+	// Each batch is carried down the tree together, so every quadrant on the way is read once rather than once per shape
+	std::vector<uint32_t> touched;
+	std::vector<Pending> pending;
+	for (int adding = 0; adding < 2; adding++) {
+		const std::vector<Geometry*>& batch = adding ? added : removed;
+		pending.resize(batch.size());
+		for (size_t i = 0; i < batch.size(); i++) {
+			pending[i].g = batch[i];
+			pending[i].bounds = batch[i]->bounds;
+			pending[i].center = centerOf(pending[i].bounds);
+			pending[i].key = LinearQuadtree::encode(pending[i].center.x, pending[i].center.y);
+		}
+		if (adding) {
+			// Shapes pushed down a splitting leaf claim quadrants from the pool in list order, so a list in Z-order of
+			// their centres leaves neighbouring quadrants close together in memory
+			std::sort(pending.begin(), pending.end(), [](const Pending& a, const Pending& b) { return a.key > b.key; });
+		}
+		descend(ROOT, pending.data(), pending.data() + pending.size(), adding != 0, touched);
+	}
+
+	// Merge from the deepest touched parents upwards, a level at a time. A parent with too much below it to collapse
+	// has an ancestor with at least as much, so only the parent of a collapsed quadrant needs looking at next
+	std::vector<uint32_t> levels[MAX_DEPTH_LIMIT + 1];
+	for (uint32_t q : touched) {
+		uint32_t parent = quadrants[q].isParent() ? q : quadrants[q].parent;
+		if (parent != NONE) {
+			levels[quadrants[parent].depth].push_back(parent);
+		}
+	}
+	for (int depth = MAX_DEPTH_LIMIT; depth >= 0; depth--) {
+		std::vector<uint32_t>& level = levels[depth];
+		std::sort(level.begin(), level.end());
+		level.erase(std::unique(level.begin(), level.end()), level.end());
+		for (uint32_t q : level) {
+			if (!quadrants[q].isParent() || !linesEligibleForRemoval(q)) {
+				continue;
 			}
-			for (Quadrant* q : parentOfRemoved->children) {
-				if (q->p) {
-					parentOfRemoved->p = q->p;
-					q->p = nullptr;
-				}
-				delete q;
+			collapse(q);
+			if (quadrants[q].parent != NONE) {
+				levels[depth - 1].push_back(quadrants[q].parent);
 			}
-			parentOfRemoved->resetChildren();
+		}
+	}
+
+	// Then split whichever touched leaves survived the merge over capacity. Merged quadrants hold no more than the
+	// capacity, so nothing is split that was just collapsed, and splitting a leaf twice does nothing the second time
+	for (uint32_t q : touched) {
+		if (q == ROOT || quadrants[q].parent != NONE) {
+			split(q);
+		}
+	}
+}
+
+void Quadtree::descend(uint32_t q, Pending* begin, Pending* end, bool adding, std::vector<uint32_t>& touched) {
+	// Sort the run into those staying here, then those for each child in turn
+	const Quadrant& quadrant = quadrants[q];
+	for (Pending* p = begin; p < end; p++) {
+		p->child = NONE;
+		if (quadrant.isParent()) {
+			uint32_t child = findChildQuadrant(q, p->center);
+			p->child = quadrants[child].loose.contains(p->bounds) ? child : NONE;
+		}
+	}
+	Pending* cursor = std::partition(begin, end, [](const Pending& p) { return p.child == NONE; });
+	for (Pending* p = begin; p < cursor; p++) {
+		if (adding) {
+			uint32_t item = allocateItem(p->g);
+			items[item].next = quadrants[q].firstItem;
+			quadrants[q].firstItem = item;
+			quadrants[q].itemCount++;
+		} else {
+			unlinkItem(q, p->g);
+		}
+	}
+	if (cursor > begin) {
+		touched.push_back(q);
+	}
+	if (cursor == end) {
+		return;
+	}
+	uint32_t first = quadrants[q].children;
+	for (uint32_t c = first; c < first + 4; c++) {
+		Pending* next = std::partition(cursor, end, [c](const Pending& p) { return p.child == c; });
+		if (next > cursor) {
+			descend(c, cursor, next, adding, touched);
+		}
+		cursor = next;
+	}
+}
+
+uint32_t Quadtree::unlinkItem(Geometry* g) {
+	uint32_t holder = findQuadrant(g);
+	return unlinkItem(holder, g) ? holder : NONE;
+}
+
+bool Quadtree::unlinkItem(uint32_t holder, Geometry* g) {
+	uint32_t* link = &quadrants[holder].firstItem;
+	while (*link != NONE && items[*link].g != g) {
+		link = &items[*link].next;
+	}
+	if (*link == NONE) {
+		return false;
+	}
+	uint32_t item = *link;
+	*link = items[item].next;
+	releaseItem(item);
+	quadrants[holder].itemCount--;
+	return true;
+}
 
-			if (parentOfRemoved->parent) {
-				parentsOfRemoved.insert(parentOfRemoved->parent);
+uint32_t Quadtree::findQuadrant(Geometry* g) const {
+	// Shapes are placed by their bounds alone, so the path taken when adding is retraced exactly
+	uint32_t q = ROOT;
+	for (uint32_t next = findChildQuadrant(q, g); next != NONE; next = findChildQuadrant(q, g)) {
+		q = next;
+	}
+	return q;
+}
+
+template <typename Meets>
+void Quadtree::collect(Meets meets, std::vector<Geometry*>& results) const {
+	uint32_t open[4 * 64]; // Each level pushes at most four, and depth is bounded by the 32 bit coordinates
+	int count = 0;
+	open[count++] = ROOT;
+	while (count > 0) {
+		const Quadrant& q = quadrants[open[--count]];
+		if (!meets(q.loose)) {
+			continue;
+		}
+		for (uint32_t item = q.firstItem; item != NONE; item = items[item].next) {
+			if (meets(items[item].g->bounds)) {
+				results.push_back(items[item].g);
+			}
+		}
+		if (q.isParent()) {
+			for (uint32_t c = q.children; c < q.children + 4; c++) {
+				if (!quadrants[c].isEmpty()) {
+					open[count++] = c;
+				}
 			}
 		}
-		parentsOfRemoved.erase(parentOfRemoved);
 	}
 }
 
-void Quadtree::assignPoint(const Point2d& p) {
-	Quadrant* ptr = root;
-	// While the current quadrant has children, step down until we find a viable, non-divided (and possibly empty) quadrant to place point
-	while (ptr->isParent()) {
-		Quadrant* next = ptr->findChildQuadrant(p);
-		ptr = next;
+void Quadtree::queryRect(const BoundingBox& box, std::vector<Geometry*>& results) const {
+	if (box.isEmpty()) {
+		return;
+	}
+	collect([&box](const BoundingBox& b) { return box.overlaps(b); }, results);
+}
+
+void Quadtree::querySegment(const Point2d& a, const Point2d& b, std::vector<Geometry*>& results) const {
+	collect([&a, &b](const BoundingBox& box) { return box.meetsSegment(a, b); }, results);
+}
+
+void Quadtree::queryCircle(const Point2d& center, uint32_t radius, std::vector<Geometry*>& results) const {
+	collect([&center, radius](const BoundingBox& box) { return box.distanceSquared(center) <= (double)radius * radius; }, results);
+}
+
+void Quadtree::queryWedge(const Wedge& wedge, std::vector<Geometry*>& results) const {
+	collect([&wedge](const BoundingBox& box) { return wedge.meets(box); }, results);
+}
+
+void Quadtree::queryPoints(const std::vector<Point2d>& points, std::vector<uint32_t>& offsets, std::vector<Geometry*>& results) const {
+	// Each open quadrant owns a run of indices into pending, the points within its loose bounds. A child's run is
+	// filtered from its parent's onto the end, so every quadrant is visited once for the whole batch
+	std::vector<uint32_t> pending(points.size());
+	for (uint32_t i = 0; i < points.size(); i++) {
+		pending[i] = i;
+	}
+	struct Run {
+		uint32_t q;
+		size_t begin, end;
+	};
+	std::vector<Run> open = { { ROOT, 0, pending.size() } };
+	std::vector<std::pair<uint32_t, Geometry*>> found;
+	while (!open.empty()) {
+		Run run = open.back();
+		open.pop_back();
+		const Quadrant& q = quadrants[run.q];
+		for (uint32_t item = q.firstItem; item != NONE; item = items[item].next) {
+			const BoundingBox& bounds = items[item].g->bounds;
+			for (size_t i = run.begin; i < run.end; i++) {
+				if (bounds.contains(points[pending[i]])) {
+					found.push_back(std::make_pair(pending[i], items[item].g));
+				}
+			}
+		}
+		if (!q.isParent()) {
+			continue;
+		}
+		for (uint32_t c = q.children; c < q.children + 4; c++) {
+			if (quadrants[c].isEmpty()) {
+				continue;
+			}
+			size_t begin = pending.size();
+			for (size_t i = run.begin; i < run.end; i++) {
+				if (quadrants[c].loose.contains(points[pending[i]])) {
+					pending.push_back(pending[i]);
+				}
+			}
+			if (pending.size() > begin) {
+				open.push_back({ c, begin, pending.size() });
+			}
+		}
+	}
+
+	// Counting sort of the matches by point
+	size_t base = results.size();
+	offsets.assign(points.size() + 1, (uint32_t)base);
+	for (const auto& f : found) {
+		offsets[f.first + 1]++;
+	}
+	for (size_t i = 1; i < offsets.size(); i++) {
+		offsets[i] += offsets[i - 1] - (uint32_t)base;
+	}
+	results.resize(base + found.size());
+	std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+	for (const auto& f : found) {
+		results[cursor[f.first]++] = f.second;
 	}
- 	ptr->assignPoint(p, gridLines);
 }
 
-Quadtree::Quadrant* Quadtree::unassignPoint(const Point2d& p) {
-	// Step down to the quadrant containing the point in question
-	Quadrant* ptr = root;
-	while (ptr->isParent()) {
-		Quadrant* next = ptr->findChildQuadrant(p);
-		ptr = next;
+void Quadtree::nearest(const Point2d& p, uint32_t k, std::vector<Geometry*>& results) const {
+	if (k == 0) {
+		return;
+	}
+	// Best first over quadrants by the distance to their loose bounds, which no shape below them can be nearer than
+	typedef std::pair<double, uint32_t> Entry;
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+	open.push(Entry(0, ROOT));
+	std::vector<std::pair<double, Geometry*>> best; // Ascending by distance, at most k long
+	while (!open.empty()) {
+		Entry entry = open.top();
+		if (best.size() == k && entry.first > best.back().first) {
+			break;
+		}
+		open.pop();
+		const Quadrant& q = quadrants[entry.second];
+		for (uint32_t item = q.firstItem; item != NONE; item = items[item].next) {
+			std::pair<double, Geometry*> candidate(sqrt(items[item].g->bounds.distanceSquared(p)), items[item].g);
+			best.insert(std::upper_bound(best.begin(), best.end(), candidate), candidate);
+			if (best.size() > k) {
+				best.pop_back();
+			}
+		}
+		if (q.isParent()) {
+			for (uint32_t c = q.children; c < q.children + 4; c++) {
+				if (!quadrants[c].isEmpty()) {
+					open.push(Entry(sqrt(quadrants[c].loose.distanceSquared(p)), c));
+				}
+			}
+		}
 	}
-	// Null the point being removed
-	ptr->p = nullptr;
-	if (ptr->parent) {
-		return ptr->parent;
+	for (const auto& b : best) {
+		results.push_back(b.second);
 	}
-	return nullptr;
 }
 
-void Quadtree::Quadrant::resetChildren() {
-	children = std::vector<Quadrant*>(0);
-	quadrantLines = std::vector<Line*>(0);
+const Quadtree::Grid& Quadtree::getGrid() {
+	if (grid.version == version) {
+		return grid;
+	}
+	grid.horizontal.clear();
+	grid.vertical.clear();
+	std::vector<uint32_t> open = { ROOT };
+	while (!open.empty()) {
+		const Quadrant& q = quadrants[open.back()];
+		open.pop_back();
+		if (!q.isParent()) {
+			continue;
+		}
+		// The crossed gridlines of a segmented quadrant are 1 pixel apart, so all four spans are required to draw the cross pattern
+		const Quadrant& bottomLeft = quadrants[q.children];
+		const Quadrant& bottomRight = quadrants[q.children + 3];
+		grid.vertical.push_back({ bottomLeft.right, q.top, q.bottom });
+		grid.vertical.push_back({ bottomRight.left, q.top, q.bottom });
+		grid.horizontal.push_back({ bottomLeft.top - 1, q.left, q.right });
+		grid.horizontal.push_back({ bottomLeft.top, q.left, q.right });
+		for (uint32_t c = q.children; c < q.children + 4; c++) {
+			open.push_back(c);
+		}
+	}
+	grid.version = version;
+	return grid;
 }
 
-std::vector<Line*>* Quadtree::getQuadtreeGrid() {
-	
-	return &gridLines;
+Quadtree::Stats Quadtree::getStats() const {
+	Stats stats;
+	std::vector<uint32_t> open = { ROOT };
+	while (!open.empty()) {
+		const Quadrant& q = quadrants[open.back()];
+		open.pop_back();
+		stats.quadrants++;
+		if (q.itemCount || q.isParent()) {
+			stats.depth = max(stats.depth, (uint32_t)q.depth);
+		}
+		if (q.isParent()) {
+			for (uint32_t c = q.children; c < q.children + 4; c++) {
+				open.push_back(c);
+			}
+			continue;
+		}
+		stats.leaves++;
+		stats.largestBucket = max(stats.largestBucket, q.itemCount);
+		if (q.itemCount > bucketCapacity) {
+			stats.overflowing++;
+		}
+	}
+	return stats;
 }
 
 std::string Quadtree::toString() {
-	Quadrant* q = root;
 	int depth = 0;
-	std::string output = q->toString(depth);
+	std::string output = toString(ROOT, depth);
 
 	return output;
 }
 
-std::string Quadtree::Quadrant::toString(int depth) {
+std::string Quadtree::toString(uint32_t index, int depth) {
 
+	const Quadrant& q = quadrants[index];
 	std::ostringstream output;
 	std::string indent = "";
 	for (int i = 0; i < depth; i++) {
@@ -235,19 +553,19 @@ std::string Quadtree::Quadrant::toString(int depth) {
 		//output << "\t";
 	}
 	output << indent;
-	output << "Left: " << this->left;
-	output << " || Top: " << this->top;
-	output << " || Right: " << this->right;
-	output << " || Bottom: " << this->bottom << "\n";
-	if (p) {
-		output << indent << "\tp: X " << p->x << " : Y " << p->y << "\n";
+	output << "Left: " << q.left;
+	output << " || Top: " << q.top;
+	output << " || Right: " << q.right;
+	output << " || Bottom: " << q.bottom << "\n";
+	if (q.itemCount) {
+		output << indent << "\titems: " << q.itemCount << "\n";
 	}
 
-	if (isParent()) {
-		for (int i = 0; i < children.size(); i++) {
-			output << children.at(i)->toString(depth + 1);
+	if (q.isParent()) {
+		for (uint32_t c = q.children; c < q.children + 4; c++) {
+			output << toString(c, depth + 1);
 		}
 	}
 
 	return output.str();
-}
\ No newline at end of file
+}
@@ -5,74 +5,135 @@
 #include <cstdint>
 #include <sstream>
 #include <map>
+#include <queue>
 #include <set>
 
 #include "geometry.h"
+#include "spatial_index.h"
 
-class Quadtree {
+class Quadtree : public SpatialIndex {
 
 private:
 
+	static constexpr uint32_t NONE = UINT32_MAX;
+
+	// Quadrants live in one pool and refer to each other by index. The four children of a quadrant are allocated
+	// together, so a single index reaches all of them and one descent step stays within a couple of cache lines
 	struct Quadrant {
 		uint32_t left;
 		uint32_t right;
 		uint32_t top;
 		uint32_t bottom;
-		uint16_t depth;
-		Point2d* p = nullptr;
-		Quadrant* parent = nullptr;
-		std::vector<Line*> quadrantLines;
-		std::vector<Quadrant*> children; // Quadrants indexed bottom left, clockwise around
-
-		Quadrant(uint32_t left, uint32_t bottom, uint32_t right, uint32_t top, Quadrant* parent);
-		~Quadrant();
-
-		void assignPoint(const Point2d& p_p, std::vector<Line*>& lines);
-		bool linesEligibleForRemoval();
-
-		Quadrant* findChildQuadrant(const Point2d& p_p);
-
-		bool collidesWith(const Point2d& p) { return (p.x >= left && p.x <= right && p.y >= top && p.y <= bottom); }; // top and bottom refer to their respective locales on screen but the row count is reversed due to how the draw area is index
-		bool isParent() { return children.size() > 0; };
-		std::string toString(int depth);
-		void resetChildren();
-
-		bool operator==(const Quadrant& obj) const {
-			return left == obj.left && right == obj.right && top == obj.top && bottom == obj.bottom;
-		}
-
-		bool operator>(const Quadrant& obj) const {
-			return depth > obj.depth;
-		}
-
-	private:
-		uint16_t sumValidPointsRemaining();
-		void segmentQuadrant(std::vector<Line*>& lines);
-		uint32_t getHeight() { return bottom - top; };
-		uint32_t getWidth() { return right - left; };
+		BoundingBox loose; // Bounds grown by the tree's looseness, containing every shape held at or below this quadrant
+		uint32_t splitX = 0; // Left edge of the right hand children
+		uint32_t splitY = 0; // Bottom edge of the top children
+		uint32_t parent = NONE;
+		uint32_t children = NONE; // First of four siblings indexed bottom left, clockwise around. Links the free list while pooled
+		uint32_t firstItem = NONE; // Shapes too large for any child's loose bounds, or waiting for this leaf to split
+		uint32_t itemCount = 0; // Unbounded at the maximum depth, where a leaf keeps every shape reaching it
+		uint16_t depth = 0;
+
+		bool collidesWith(const Point2d& p) const { return (p.x >= left && p.x <= right && p.y >= top && p.y <= bottom); }; // top and bottom refer to their respective locales on screen but the row count is reversed due to how the draw area is index
+		BoundingBox getBounds() const { return BoundingBox(left, top, right, bottom); };
+		bool isParent() const { return children != NONE; };
+		bool isEmpty() const { return itemCount == 0 && !isParent(); };
+		uint32_t getHeight() const { return bottom - top; };
+		uint32_t getWidth() const { return right - left; };
 	};
 
-public:
-	Quadtree(const Rect& r);
-	~Quadtree();
+	// A shape being carried down the tree by update, with the bounds it is placed by copied alongside
+	struct Pending {
+		Geometry* g;
+		BoundingBox bounds;
+		Point2d center;
+		uint64_t key; // Morton code of the centre
+		uint32_t child;
+	};
+
+	// Singly linked list node of a quadrant's shapes, pooled alongside the quadrants
+	struct Item {
+		Geometry* g;
+		uint32_t next;
+	};
 
-	struct byDepth {
-		bool operator()(const Quadrant* a, const Quadrant* b) const {
-			return a->depth > b->depth;
-		}
+public:
+	// Loose bounds are this many times the size of their quadrant. At 2 any shape no larger than a quadrant fits in the
+	// child holding its centre, so shapes settle by size instead of sticking wherever they straddle a split
+	static constexpr double DEFAULT_LOOSENESS = 2.0;
+	// A leaf splits once it holds more shapes than its bucket capacity, unless it is already at the maximum depth. Leaves
+	// there become overflow buckets instead, so coincident shapes such as shared corners cannot divide the tree forever
+	static constexpr uint32_t DEFAULT_BUCKET_CAPACITY = 8;
+	static constexpr uint16_t DEFAULT_MAX_DEPTH = 16;
+	static constexpr uint16_t MAX_DEPTH_LIMIT = 32; // Quadrants of 32 bit coordinates are single pixels by then
+
+	struct Stats {
+		uint32_t quadrants = 0;
+		uint32_t leaves = 0;
+		uint32_t depth = 0; // Deepest quadrant holding or dividing into anything
+		uint32_t overflowing = 0; // Leaves past their bucket capacity, being at the maximum depth or too small to divide
+		uint32_t largestBucket = 0;
 	};
 
+	Quadtree(const Rect& r, double looseness = DEFAULT_LOOSENESS, uint32_t bucketCapacity = DEFAULT_BUCKET_CAPACITY, uint16_t maxDepth = DEFAULT_MAX_DEPTH);
+	SpatialIndex* clone() const { return new Quadtree(*this); };
+	Type getType() const { return QUADTREE; };
+
 	void addGeometry(Geometry* g);
+	void addGeometry(const std::vector<Geometry*>& geometry);
 	void removeGeometry(Geometry* g);
-	std::vector<Line*>* getQuadtreeGrid();
+	void removeGeometry(const std::vector<Geometry*>& geometry);
+	// Removes then adds many shapes together, followed by a single pass that collapses and splits only the quadrants
+	// they touched. Replacing a large selection costs one pass over the tree rather than one per shape
+	void update(const std::vector<Geometry*>& added, const std::vector<Geometry*>& removed);
+	void queryRect(const BoundingBox& box, std::vector<Geometry*>& results) const;
+	void querySegment(const Point2d& a, const Point2d& b, std::vector<Geometry*>& results) const;
+	void queryCircle(const Point2d& center, uint32_t radius, std::vector<Geometry*>& results) const;
+	void queryWedge(const Wedge& wedge, std::vector<Geometry*>& results) const;
+	// Shapes whose bounds contain each of many points, found in one shared descent. The shapes for points[i] are
+	// results[offsets[i]] up to results[offsets[i + 1]]
+	void queryPoints(const std::vector<Point2d>& points, std::vector<uint32_t>& offsets, std::vector<Geometry*>& results) const;
+	// Appends the k shapes whose bounds are closest to p, nearest first
+	void nearest(const Point2d& p, uint32_t k, std::vector<Geometry*>& results) const;
+	// Rebuilt in one traversal only when the tree has split or collapsed since the last call
+	const Grid& getGrid();
+	uint64_t getVersion() const { return version; };
+	Stats getStats() const;
 	std::string toString();
 
 protected:
-	void assignPoint(const Point2d& p);
-	Quadrant* unassignPoint(const Point2d& p);
-
-	Quadrant* root;
-	std::vector<Line*> gridLines;
+	uint32_t allocateChildren();
+	void releaseChildren(uint32_t first); // Released quadrants have no parent, which only the root shares
+	uint32_t allocateItem(Geometry* g);
+	void releaseItem(uint32_t item);
+
+	void initQuadrant(uint32_t q, uint32_t left, uint32_t bottom, uint32_t right, uint32_t top, uint32_t parent);
+	void assignItem(uint32_t q, uint32_t item);
+	void split(uint32_t q); // Divide a leaf holding more than its capacity and push its shapes down, if it can be divided
+	uint32_t unlinkItem(Geometry* g); // Returns the quadrant that held g, or NONE if the tree does not hold it
+	bool unlinkItem(uint32_t holder, Geometry* g);
+	void descend(uint32_t q, Pending* begin, Pending* end, bool adding, std::vector<uint32_t>& touched);
+	void segmentQuadrant(uint32_t q);
+	void collapse(uint32_t q); // Pull every shape below q up into it and return its children to the pool
+	bool linesEligibleForRemoval(uint32_t q);
+	uint32_t sumValidItemsRemaining(uint32_t q);
+	uint32_t findChildQuadrant(uint32_t q, const Point2d& p) const;
+	uint32_t findChildQuadrant(uint32_t q, Geometry* g) const; // Child a shape belongs in, or NONE if it must stay at q
+	uint32_t findQuadrant(Geometry* g) const;
+	// Gathers the shapes passing meets from every quadrant whose loose bounds pass it, skipping the rest whole
+	template <typename Meets>
+	void collect(Meets meets, std::vector<Geometry*>& results) const;
+	std::string toString(uint32_t q, int depth);
+
+	static constexpr uint32_t ROOT = 0;
+	std::vector<Quadrant> quadrants;
+	std::vector<Item> items;
+	uint32_t freeQuadrants = NONE; // First of the next free group of four siblings
+	uint32_t freeItems = NONE;
+	double looseness;
+	uint32_t bucketCapacity;
+	uint16_t maxDepth;
+	uint64_t version = 1; // Advanced whenever a quadrant splits or collapses
+	Grid grid;
 };
 
 
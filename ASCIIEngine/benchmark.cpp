@@ -0,0 +1,929 @@
+#include "benchmark.h"
+#include "bsp_tree.h"
+#include "debug.h"
+#include "input.h"
+#include "key_state.h"
+#include "level.h"
+#include "linear_quadtree.h"
+#include "published_index.h"
+#include "quadtree.h"
+#include "snapshot_index.h"
+#include "uniform_grid.h"
+#include "visible_set.h"
+#include <cfloat>
+#include <thread>
+
+namespace {
+	// Fixed seed linear congruential generator, so each run builds the same scene
+	struct Lcg {
+		uint32_t seed = 12345;
+
+		uint32_t next(uint32_t range) { seed = seed * 1664525 + 1013904223; return (seed >> 8) % range; };
+	};
+
+	// The angle based response simulateFrame used before the projection solver, kept as the benchmark baseline
+	void legacyResponse(const ContactManifold& contacts, double& dPx, double& dPy, double ax, double ay) {
+		for (int i = 0; i < contacts.size(); i++) {
+			const Contact& contact = contacts[i];
+			double tx, ty;
+			contact.calculateTangent(tx, ty);
+			if (abs(acos(contact.nx * tx + contact.ny * ty) * 180 / M_PI - 90) > 3) {
+				continue;
+			}
+
+			double angleOfXAxisToSide = acos(tx);
+			double alpha = angleOfXAxisToSide > 90 ? (180 - angleOfXAxisToSide) : angleOfXAxisToSide;
+			double totalVelocity = sqrt(dPx * dPx + dPy * dPy);
+			double angleOfMotionToSide = acos((dPx * tx + dPy * ty) / totalVelocity);
+			double gamma = angleOfMotionToSide > 90 ? (180 - angleOfMotionToSide) : angleOfMotionToSide;
+			double newVelocity = totalVelocity * cos(gamma);
+
+			if (contact.nx * ax < 0) {
+				dPx = newVelocity * cos(alpha);
+			}
+			if (contact.ny * ay < 0) {
+				dPy = newVelocity * sin(alpha);
+			}
+		}
+	}
+
+	// Contact on side a -> b of a line, with the normal facing the camera at (px, py)
+	Contact makeContact(Line* side, double px, double py) {
+		Contact contact;
+		double dx = (double)side->vertices[1].x - side->vertices[0].x;
+		double dy = (double)side->vertices[1].y - side->vertices[0].y;
+		double length = sqrt(dx * dx + dy * dy);
+		contact.nx = -dy / length;
+		contact.ny = dx / length;
+		if ((px - side->vertices[0].x) * contact.nx + (py - side->vertices[0].y) * contact.ny < 0) {
+			contact.nx = -contact.nx;
+			contact.ny = -contact.ny;
+		}
+		contact.point = side->vertices[0];
+		contact.depth = 1;
+		contact.geometry = side;
+		contact.edge = 0;
+		return contact;
+	}
+
+	struct Scenario {
+		const char* name;
+		Line sides[2];
+		int count;
+		double dx, dy;
+		bool stops; // Expected to lose all motion, rather than slide keeping the part along the wall
+	};
+
+	// Checks the solver's result against what the scenario expects. Whatever the case, no motion may be left pushing into
+	// a contact. A stop must leave none at all, and a slide along one wall must keep exactly the part along it
+	bool checkResponse(const Scenario& scenario, const ContactManifold& contacts, double x, double y) {
+		const double TOLERANCE = 1e-6;
+		for (int i = 0; i < contacts.size(); i++) {
+			if (x * contacts[i].nx + y * contacts[i].ny < -TOLERANCE) {
+				return false;
+			}
+		}
+		if (scenario.stops) {
+			return fabs(x) < TOLERANCE && fabs(y) < TOLERANCE;
+		}
+		if (contacts.size() == 1) {
+			double tx, ty;
+			contacts[0].calculateTangent(tx, ty);
+			double along = scenario.dx * tx + scenario.dy * ty;
+			return fabs(x - along * tx) < TOLERANCE && fabs(y - along * ty) < TOLERANCE;
+		}
+		return true;
+	}
+
+	// Shapes and queries run identically against every index spatialIndexes compares
+	struct IndexWorkload {
+		std::vector<Geometry*> scene;
+		std::vector<BoundingBox> regions;
+		std::vector<std::pair<Point2d, Point2d>> segments;
+		std::vector<Point2d> points; // Circle centres and nearest queries
+		std::vector<Wedge> wedges;
+	};
+
+	// What every query of a workload found, in workload order, for comparing one index against another
+	struct IndexAnswers {
+		std::vector<std::vector<Geometry*>> found; // Sorted by address
+		std::vector<std::vector<double>> nearest; // Distances only, since shapes at equal distances may come in any order
+	};
+
+	void recordAnswers(const SpatialIndex* index, const IndexWorkload& w, IndexAnswers& answers) {
+		std::vector<Geometry*> results;
+		auto keep = [&]() {
+			std::sort(results.begin(), results.end());
+			answers.found.push_back(results);
+			results.clear();
+		};
+		for (size_t i = 0; i < w.regions.size(); i++) {
+			index->queryRect(w.regions[i], results);
+			keep();
+			index->querySegment(w.segments[i].first, w.segments[i].second, results);
+			keep();
+			// Wider than the timed circles, so each spans several cells of every grid
+			index->queryCircle(w.points[i], 300, results);
+			keep();
+			index->queryWedge(w.wedges[i], results);
+			keep();
+			index->nearest(w.points[i], 8, results);
+			std::vector<double> distances;
+			for (Geometry* g : results) {
+				distances.push_back(g->bounds.distanceSquared(w.points[i]));
+			}
+			answers.nearest.push_back(distances);
+			results.clear();
+		}
+	}
+
+	// Queries whose answers differ between two runs of the same workload
+	uint32_t countDifferences(const IndexAnswers& a, const IndexAnswers& b) {
+		uint32_t differences = (uint32_t)(a.found.size() != b.found.size()) + (uint32_t)(a.nearest.size() != b.nearest.size());
+		for (size_t i = 0; i < min(a.found.size(), b.found.size()); i++) {
+			differences += a.found[i] != b.found[i];
+		}
+		for (size_t i = 0; i < min(a.nearest.size(), b.nearest.size()); i++) {
+			differences += a.nearest[i] != b.nearest[i];
+		}
+		return differences;
+	}
+
+	// Times the workload, recording every query's answer over the full scene and again once it has been thinned
+	std::string runIndexWorkload(SpatialIndex* index, const IndexWorkload& w, IndexAnswers& answers) {
+		std::vector<Geometry*> results;
+		double insertNs = Benchmark::measure([&]() { index->addGeometry(w.scene); }, 1);
+		uint32_t i = 0;
+		double rectNs = Benchmark::measure([&]() { results.clear(); index->queryRect(w.regions[i++], results); }, (uint32_t)w.regions.size());
+		i = 0;
+		double segmentNs = Benchmark::measure([&]() { results.clear(); index->querySegment(w.segments[i].first, w.segments[i].second, results); i++; }, (uint32_t)w.segments.size());
+		i = 0;
+		double circleNs = Benchmark::measure([&]() { results.clear(); index->queryCircle(w.points[i++], 20, results); }, (uint32_t)w.points.size());
+		i = 0;
+		double nearestNs = Benchmark::measure([&]() { results.clear(); index->nearest(w.points[i++], 8, results); }, (uint32_t)w.points.size());
+		recordAnswers(index, w, answers);
+		// Every other shape, one at a time, then the rect queries again over the thinned scene
+		double removeNs = Benchmark::measure([&]() {
+			for (size_t g = 0; g < w.scene.size(); g += 2) {
+				index->removeGeometry(w.scene[g]);
+			}
+		}, 1);
+		i = 0;
+		double thinnedNs = Benchmark::measure([&]() { results.clear(); index->queryRect(w.regions[i++], results); }, (uint32_t)w.regions.size());
+		recordAnswers(index, w, answers);
+
+		std::stringstream s;
+		s << std::fixed << std::setprecision(0) << "insert " << insertNs / 1e6 << "ms\trect " << rectNs << "ns\tsegment " << segmentNs << "ns\tcircle " << circleNs
+			<< "ns\tnearest " << nearestNs << "ns\tremove " << removeNs / 1e6 << "ms\trect after " << thinnedNs << "ns";
+		return s.str();
+	}
+}
+
+void Benchmark::report(const std::string& line) {
+	Debug::DebugMessage dbg(BENCHMARK_CLASS, BENCHMARK);
+	dbg.setOutputString(line);
+	Debug::Print(&dbg);
+}
+
+void Benchmark::collisionResponse() {
+	// Camera sits at (100, 100) in each case, motion is in pixels per frame
+	Scenario scenarios[] = {
+		{ "head on", { Line(Point2d(0, 105), Point2d(200, 105)) }, 1, 0, 4, true },
+		{ "flat wall", { Line(Point2d(0, 105), Point2d(200, 105)) }, 1, 3, 4, false },
+		{ "shallow 5deg", { Line(Point2d(0, 96), Point2d(200, 113)) }, 1, 5, 0.5, false },
+		{ "square corner", { Line(Point2d(0, 105), Point2d(200, 105)), Line(Point2d(105, 0), Point2d(105, 200)) }, 2, 3, 4, true },
+		{ "acute corner", { Line(Point2d(0, 105), Point2d(200, 105)), Line(Point2d(90, 0), Point2d(110, 200)) }, 2, 4, 3, true },
+	};
+
+	for (Scenario& scenario : scenarios) {
+		ContactManifold contacts;
+		for (int i = 0; i < scenario.count; i++) {
+			contacts.add(makeContact(&scenario.sides[i], 100, 100));
+		}
+
+		// Results of one call each, then the mean cost over many
+		double legacyX = scenario.dx, legacyY = scenario.dy;
+		legacyResponse(contacts, legacyX, legacyY, scenario.dx, scenario.dy);
+		double solverX = scenario.dx, solverY = scenario.dy;
+		contacts.resolveDisplacement(solverX, solverY);
+
+		volatile double sink = 0;
+		double legacyNs = measure([&]() {
+			double x = scenario.dx, y = scenario.dy;
+			legacyResponse(contacts, x, y, scenario.dx, scenario.dy);
+			sink = x + y;
+		});
+		double solverNs = measure([&]() {
+			double x = scenario.dx, y = scenario.dy;
+			contacts.resolveDisplacement(x, y);
+			sink = x + y;
+		});
+
+		std::stringstream s;
+		s << std::fixed << std::setprecision(2) << scenario.name << "\t" << (checkResponse(scenario, contacts, solverX, solverY) ? "pass" : "FAIL")
+			<< "\tlegacy: (" << legacyX << ", " << legacyY << ") " << legacyNs << "ns\tsolver: (" << solverX << ", " << solverY << ") " << solverNs << "ns\n";
+		report(s.str());
+	}
+}
+
+void Benchmark::levelImport() {
+	const char* path = "level_benchmark.bin";
+	std::vector<Geometry*> geometry;
+	geometry.reserve(LEVEL_SEGMENTS);
+	// The same level on every run
+	Lcg lcg;
+	for (uint32_t i = 0; i < LEVEL_SEGMENTS; i++) {
+		geometry.push_back(new Line(Point2d(lcg.next(1024), lcg.next(1024)), Point2d(lcg.next(1024), lcg.next(1024))));
+	}
+	bool saved = Level::saveBinary(path, geometry);
+	for (Geometry* g : geometry) {
+		delete g;
+	}
+	geometry.clear();
+	if (!saved) {
+		report("level import\tcould not write " + std::string(path) + "\n");
+		return;
+	}
+
+	bool loaded = false;
+	double loadNs = measure([&]() { loaded = Level::load(path, geometry); }, 1);
+	std::stringstream s;
+	s << std::fixed << std::setprecision(1) << "level import\t" << (loaded ? "" : "FAILED ") << geometry.size() << " segments in " << loadNs / 1e6 << "ms\n";
+	report(s.str());
+
+	for (Geometry* g : geometry) {
+		delete g;
+	}
+	geometry.clear();
+	DeleteFileA(path);
+
+	// Startup to a first query, with the same scene saved both ways
+	const char* snapshotPath = "startup_benchmark.snapshot";
+	geometry.reserve(STARTUP_SHAPES);
+	for (uint32_t i = 0; i < STARTUP_SHAPES; i++) {
+		uint32_t x = lcg.next(1024) * 64, y = lcg.next(1024) * 64;
+		geometry.push_back(new Line(Point2d(x, y), Point2d(x + lcg.next(64), y + lcg.next(64))));
+	}
+	saved = Level::saveBinary(path, geometry) && Snapshot::write(snapshotPath, geometry);
+	for (Geometry* g : geometry) {
+		delete g;
+	}
+	geometry.clear();
+	if (!saved) {
+		report("startup\tcould not write " + std::string(path) + " and " + snapshotPath + "\n");
+		DeleteFileA(path);
+		DeleteFileA(snapshotPath);
+		return;
+	}
+	BoundingBox window(STARTUP_WORLD_SIZE / 2 - 400, STARTUP_WORLD_SIZE / 2 - 300, STARTUP_WORLD_SIZE / 2 + 400, STARTUP_WORLD_SIZE / 2 + 300);
+	std::vector<Geometry*> fromLevel, fromSnapshot;
+	Quadtree* qt = nullptr;
+	double levelNs = measure([&]() {
+		loaded = Level::load(path, geometry);
+		qt = new Quadtree(Rect(Point2d(0, 0), Point2d(STARTUP_WORLD_SIZE, STARTUP_WORLD_SIZE)));
+		qt->addGeometry(geometry);
+		qt->queryRect(window, fromLevel);
+	}, 1);
+	Snapshot::View view;
+	SnapshotIndex* index = nullptr;
+	bool opened = false;
+	double snapshotNs = measure([&]() {
+		opened = view.open(snapshotPath);
+		index = new SnapshotIndex(view);
+		index->queryRect(window, fromSnapshot);
+	}, 1);
+	s.str("");
+	s << std::fixed << std::setprecision(1) << "startup to first query\t" << (loaded && opened && fromLevel.size() == fromSnapshot.size() ? "" : "FAILED ")
+		<< "level and quadtree " << levelNs / 1e6 << "ms (" << fromLevel.size() << " found)\tsnapshot " << snapshotNs / 1e6 << "ms (" << fromSnapshot.size()
+		<< " found, " << index->getBuiltCount() << " of " << view.getShapeCount() << " shapes built)\n";
+	report(s.str());
+
+	delete index;
+	view.close();
+	delete qt;
+	for (Geometry* g : geometry) {
+		delete g;
+	}
+	DeleteFileA(path);
+	DeleteFileA(snapshotPath);
+}
+
+void Benchmark::spatialQueries() {
+	for (uint32_t count : QUERY_SCENE_SIZES) {
+		// Short walls and small boxes scattered over the world, the same scene on every run
+		Lcg lcg;
+		std::vector<Geometry*> geometry;
+		geometry.reserve(count);
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t x = lcg.next(QUERY_WORLD_SIZE - 64), y = lcg.next(QUERY_WORLD_SIZE - 64);
+			if (i % 2) {
+				geometry.push_back(new Line(Point2d(x, y), Point2d(x + lcg.next(64), y + lcg.next(64))));
+			} else {
+				geometry.push_back(new Rect(Point2d(x, y), Point2d(x + 1 + lcg.next(32), y + 1 + lcg.next(32))));
+			}
+		}
+		Quadtree* qt = nullptr;
+		double buildNs = measure([&]() { qt = new Quadtree(Rect(Point2d(0, 0), Point2d(QUERY_WORLD_SIZE, QUERY_WORLD_SIZE))); qt->addGeometry(geometry); }, 1);
+
+		// A window sized region, a long segment and a camera sized circle at a fresh position each call
+		std::vector<Geometry*> results;
+		size_t found = 0;
+		auto region = [&]() { uint32_t x = lcg.next(QUERY_WORLD_SIZE - 800), y = lcg.next(QUERY_WORLD_SIZE - 600); return BoundingBox(x, y, x + 800, y + 600); };
+		double rectNs = measure([&]() { results.clear(); qt->queryRect(region(), results); found += results.size(); }, QUERY_ITERATIONS);
+		double segmentNs = measure([&]() {
+			results.clear();
+			Point2d a(lcg.next(QUERY_WORLD_SIZE), lcg.next(QUERY_WORLD_SIZE));
+			qt->querySegment(a, Point2d(min(a.x + 2000, QUERY_WORLD_SIZE), min(a.y + 500, QUERY_WORLD_SIZE)), results);
+		}, QUERY_ITERATIONS);
+		double circleNs = measure([&]() { results.clear(); qt->queryCircle(Point2d(lcg.next(QUERY_WORLD_SIZE), lcg.next(QUERY_WORLD_SIZE)), 20, results); }, QUERY_ITERATIONS);
+		double nearestNs = measure([&]() { results.clear(); qt->nearest(Point2d(lcg.next(QUERY_WORLD_SIZE), lcg.next(QUERY_WORLD_SIZE)), 8, results); }, QUERY_ITERATIONS);
+		// Samples marched along a fan of rays from one point, as a raycaster takes them, located together and then one at a time
+		std::vector<Point2d> points(QUERY_POINTS);
+		std::vector<uint32_t> offsets;
+		auto samplePoints = [&]() {
+			double ox = 1000 + lcg.next(QUERY_WORLD_SIZE - 2000), oy = 1000 + lcg.next(QUERY_WORLD_SIZE - 2000);
+			for (uint32_t i = 0; i < QUERY_POINTS; i++) {
+				double angle = (i / 100) * M_PI / 20, distance = (i % 100) * 8.0;
+				points[i] = Point2d((uint32_t)(ox + cos(angle) * distance), (uint32_t)(oy + sin(angle) * distance));
+			}
+		};
+		double batchNs = measure([&]() { samplePoints(); results.clear(); qt->queryPoints(points, offsets, results); }, QUERY_ITERATIONS / 10);
+		double singleNs = measure([&]() {
+			samplePoints();
+			results.clear();
+			for (const Point2d& p : points) {
+				qt->queryRect(BoundingBox(p.x, p.y, p.x, p.y), results);
+			}
+		}, QUERY_ITERATIONS / 10);
+		double scanNs = measure([&]() {
+			results.clear();
+			BoundingBox box = region();
+			for (Geometry* g : geometry) {
+				if (box.overlaps(g->bounds)) {
+					results.push_back(g);
+				}
+			}
+		}, QUERY_ITERATIONS);
+
+		std::stringstream s;
+		s << std::fixed << std::setprecision(0) << count << " shapes\tbuild " << buildNs / 1e6 << "ms\trect " << rectNs << "ns (" << found / QUERY_ITERATIONS
+			<< " hits)\tsegment " << segmentNs << "ns\tcircle " << circleNs << "ns\tnearest(8) " << nearestNs << "ns\tpoints(" << QUERY_POINTS << ") " << batchNs
+			<< "ns batched, " << singleNs << "ns singly\tscan " << scanNs << "ns\n";
+		report(s.str());
+
+		delete qt;
+		for (Geometry* g : geometry) {
+			delete g;
+		}
+	}
+}
+
+void Benchmark::linearQuadtree() {
+	// Single point lines, so both trees hold the same keys and only their layout differs
+	Lcg lcg;
+	std::vector<Geometry*> geometry;
+	geometry.reserve(LINEAR_POINTS);
+	for (uint32_t i = 0; i < LINEAR_POINTS; i++) {
+		Point2d p(lcg.next(QUERY_WORLD_SIZE), lcg.next(QUERY_WORLD_SIZE));
+		geometry.push_back(new Line(p, p));
+	}
+
+	Quadtree* qt = nullptr;
+	double treeBuildNs = measure([&]() { qt = new Quadtree(Rect(Point2d(0, 0), Point2d(QUERY_WORLD_SIZE, QUERY_WORLD_SIZE))); qt->addGeometry(geometry); }, 1);
+	LinearQuadtree lqt;
+	double linearBuildNs = measure([&]() { lqt.build(geometry); }, 1);
+
+	// Both trees see the same sequence of window sized regions
+	std::vector<BoundingBox> regions;
+	for (uint32_t i = 0; i < QUERY_ITERATIONS; i++) {
+		uint32_t x = lcg.next(QUERY_WORLD_SIZE - 800), y = lcg.next(QUERY_WORLD_SIZE - 600);
+		regions.push_back(BoundingBox(x, y, x + 800, y + 600));
+	}
+	std::vector<Geometry*> results;
+	size_t treeFound = 0, linearFound = 0;
+	uint32_t i = 0;
+	double treeNs = measure([&]() { results.clear(); qt->queryRect(regions[i++], results); treeFound += results.size(); }, QUERY_ITERATIONS);
+	i = 0;
+	double linearNs = measure([&]() { results.clear(); lqt.queryRect(regions[i++], results); linearFound += results.size(); }, QUERY_ITERATIONS);
+
+	// Stored and loaded again against the same geometry, as a level would be instead of rebuilding it
+	std::vector<uint8_t> buffer;
+	double saveNs = measure([&]() { buffer.clear(); lqt.serialize(buffer); }, 1);
+	LinearQuadtree loaded;
+	bool restored = false;
+	double loadNs = measure([&]() { restored = loaded.deserialize(buffer.data(), buffer.size(), geometry); }, 1);
+
+	// Every region must find the same shapes in all three, whatever order each reports them in
+	uint32_t mismatches = 0;
+	std::vector<Geometry*> treeResults, linearResults;
+	for (const BoundingBox& region : regions) {
+		treeResults.clear();
+		qt->queryRect(region, treeResults);
+		std::sort(treeResults.begin(), treeResults.end());
+		linearResults.clear();
+		lqt.queryRect(region, linearResults);
+		std::sort(linearResults.begin(), linearResults.end());
+		results.clear();
+		if (restored) {
+			loaded.queryRect(region, results);
+			std::sort(results.begin(), results.end());
+		}
+		mismatches += treeResults != linearResults || linearResults != results;
+	}
+	bool passed = restored && mismatches == 0 && treeFound == linearFound;
+
+	std::stringstream s;
+	s << std::fixed << std::setprecision(0) << LINEAR_POINTS << " points\t" << (passed ? "pass" : "FAIL") << "\tquadtree build " << treeBuildNs / 1e6 << "ms rect " << treeNs
+		<< "ns (" << treeFound / QUERY_ITERATIONS << " hits)\tlinear build " << linearBuildNs / 1e6 << "ms rect " << linearNs << "ns (" << linearFound / QUERY_ITERATIONS
+		<< " hits)\tsave " << saveNs / 1e6 << "ms load " << loadNs / 1e6 << "ms (" << buffer.size() / 1024 << "KB" << (restored ? "" : ", rejected")
+		<< ")\t" << mismatches << " of " << QUERY_ITERATIONS << " regions differ\n";
+	report(s.str());
+
+	delete qt;
+	for (Geometry* g : geometry) {
+		delete g;
+	}
+}
+
+void Benchmark::quadtreeTuning() {
+	// Half the scene is a grid of abutting tiles, every inner corner shared by four of them, the rest scattered walls
+	Lcg lcg;
+	std::vector<Geometry*> geometry;
+	geometry.reserve(TUNING_SHAPES);
+	uint32_t tiles = (uint32_t)sqrt(TUNING_SHAPES / 2), tileSize = QUERY_WORLD_SIZE / 4 / tiles;
+	for (uint32_t y = 0; y < tiles; y++) {
+		for (uint32_t x = 0; x < tiles; x++) {
+			geometry.push_back(new Rect(Point2d(x * tileSize, y * tileSize), Point2d((x + 1) * tileSize, (y + 1) * tileSize)));
+		}
+	}
+	while (geometry.size() < TUNING_SHAPES) {
+		uint32_t x = lcg.next(QUERY_WORLD_SIZE - 64), y = lcg.next(QUERY_WORLD_SIZE - 64);
+		geometry.push_back(new Line(Point2d(x, y), Point2d(x + lcg.next(64), y + lcg.next(64))));
+	}
+	std::vector<BoundingBox> regions;
+	for (uint32_t i = 0; i < QUERY_ITERATIONS; i++) {
+		uint32_t x = lcg.next(QUERY_WORLD_SIZE / 2 - 800), y = lcg.next(QUERY_WORLD_SIZE / 2 - 600);
+		regions.push_back(BoundingBox(x, y, x + 800, y + 600));
+	}
+
+	for (uint32_t capacity : TUNING_CAPACITIES) {
+		Quadtree* qt = nullptr;
+		double buildNs = measure([&]() {
+			qt = new Quadtree(Rect(Point2d(0, 0), Point2d(QUERY_WORLD_SIZE, QUERY_WORLD_SIZE)), Quadtree::DEFAULT_LOOSENESS, capacity);
+			qt->addGeometry(geometry);
+		}, 1);
+		Quadtree::Stats stats = qt->getStats();
+
+		std::vector<Geometry*> results;
+		uint32_t i = 0;
+		double rectNs = measure([&]() { results.clear(); qt->queryRect(regions[i++], results); }, QUERY_ITERATIONS);
+		double circleNs = measure([&]() { results.clear(); qt->queryCircle(Point2d(lcg.next(QUERY_WORLD_SIZE), lcg.next(QUERY_WORLD_SIZE)), 20, results); }, QUERY_ITERATIONS);
+
+		std::stringstream s;
+		s << std::fixed << std::setprecision(0) << "capacity " << capacity << "\tdepth " << stats.depth << "\tquadrants " << stats.quadrants << "\tleaves " << stats.leaves
+			<< "\toverflowing " << stats.overflowing << " (largest " << stats.largestBucket << ")\tbuild " << buildNs / 1e6 << "ms\trect " << rectNs << "ns\tcircle " << circleNs << "ns\n";
+		report(s.str());
+		delete qt;
+	}
+	for (Geometry* g : geometry) {
+		delete g;
+	}
+}
+
+void Benchmark::batchUpdate() {
+	Lcg lcg;
+	auto scatter = [&](std::vector<Geometry*>& geometry, uint32_t count, uint32_t range) {
+		for (uint32_t i = 0; i < count; i++) {
+			uint32_t x = lcg.next(range - 64), y = lcg.next(range - 64);
+			geometry.push_back(new Line(Point2d(x, y), Point2d(x + lcg.next(64), y + lcg.next(64))));
+		}
+	};
+	uint32_t count = QUERY_SCENE_SIZES[1];
+	std::vector<Geometry*> scene, replacement;
+	scatter(scene, count, QUERY_WORLD_SIZE);
+	// The selection is a square region of the scene holding about BATCH_SELECTION shapes, redrawn in place
+	uint32_t side = (uint32_t)(QUERY_WORLD_SIZE * sqrt((double)BATCH_SELECTION / count));
+	std::vector<Geometry*> selection;
+	for (Geometry* g : scene) {
+		if (g->bounds.minX < side && g->bounds.minY < side) {
+			selection.push_back(g);
+		}
+	}
+	scatter(replacement, (uint32_t)selection.size(), side);
+
+	Quadtree single(Rect(Point2d(0, 0), Point2d(QUERY_WORLD_SIZE, QUERY_WORLD_SIZE)));
+	Quadtree batched(Rect(Point2d(0, 0), Point2d(QUERY_WORLD_SIZE, QUERY_WORLD_SIZE)));
+	single.addGeometry(scene);
+	batched.addGeometry(scene);
+	double singleNs = measure([&]() {
+		for (Geometry* g : selection) {
+			single.removeGeometry(g);
+		}
+		for (Geometry* g : replacement) {
+			single.addGeometry(g);
+		}
+	}, 1);
+	double batchedNs = measure([&]() { batched.update(replacement, selection); }, 1);
+
+	// Both paths must leave the same tree, checked by its shape and by what it answers
+	Quadtree::Stats singleStats = single.getStats(), batchedStats = batched.getStats();
+	bool sameStats = singleStats.quadrants == batchedStats.quadrants && singleStats.leaves == batchedStats.leaves && singleStats.depth == batchedStats.depth
+		&& singleStats.overflowing == batchedStats.overflowing && singleStats.largestBucket == batchedStats.largestBucket;
+	uint32_t mismatched = 0;
+	std::vector<Geometry*> fromSingle, fromBatched;
+	for (uint32_t i = 0; i < QUERY_ITERATIONS; i++) {
+		// Half the regions inside the replaced square, half anywhere
+		uint32_t range = i % 2 ? QUERY_WORLD_SIZE : side;
+		uint32_t x = lcg.next(range), y = lcg.next(range);
+		BoundingBox region(x, y, x + 800, y + 600);
+		fromSingle.clear();
+		fromBatched.clear();
+		single.queryRect(region, fromSingle);
+		batched.queryRect(region, fromBatched);
+		std::sort(fromSingle.begin(), fromSingle.end());
+		std::sort(fromBatched.begin(), fromBatched.end());
+		mismatched += fromSingle != fromBatched;
+	}
+	std::stringstream s;
+	s << std::fixed << std::setprecision(2) << "replace " << selection.size() << " of " << count << " shapes\t" << (sameStats && mismatched == 0 ? "pass" : "FAIL")
+		<< "\tsingly " << singleNs / 1e6 << "ms (" << singleStats.quadrants << " quadrants, " << singleStats.leaves << " leaves, depth " << singleStats.depth
+		<< ")\tbatched " << batchedNs / 1e6 << "ms (" << batchedStats.quadrants << " quadrants, " << batchedStats.leaves << " leaves, depth " << batchedStats.depth
+		<< ")\t" << (sameStats ? "same" : "different") << " stats, " << mismatched << " of " << QUERY_ITERATIONS << " regions differ\n";
+	report(s.str());
+
+	for (Geometry* g : scene) {
+		delete g;
+	}
+	for (Geometry* g : replacement) {
+		delete g;
+	}
+}
+
+void Benchmark::publishedReaders() {
+	Lcg lcg;
+	std::vector<Geometry*> scene, batch;
+	for (uint32_t i = 0; i < QUERY_SCENE_SIZES[1]; i++) {
+		uint32_t x = 1024 + lcg.next(QUERY_WORLD_SIZE - 1088), y = 1024 + lcg.next(QUERY_WORLD_SIZE - 1088);
+		scene.push_back(new Line(Point2d(x, y), Point2d(x + lcg.next(64), y + lcg.next(64))));
+	}
+	// The batch goes in a corner the scene leaves empty, so a reader's query there finds all of it or none
+	BoundingBox corner(0, 0, 1000, 1000);
+	for (uint32_t i = 0; i < PUBLISH_BATCH; i++) {
+		uint32_t x = lcg.next(900), y = lcg.next(900);
+		batch.push_back(new Rect(Point2d(x, y), Point2d(x + 1 + lcg.next(99), y + 1 + lcg.next(99))));
+	}
+	Quadtree qt(Rect(Point2d(0, 0), Point2d(QUERY_WORLD_SIZE, QUERY_WORLD_SIZE)));
+	qt.addGeometry(scene);
+	PublishedIndex published;
+	uint32_t frame = 0;
+	auto writerFrame = [&]() {
+		if (frame++ % 2) {
+			qt.removeGeometry(batch);
+		} else {
+			qt.addGeometry(batch);
+		}
+		published.invalidate();
+		published.update(qt);
+	};
+
+	uint64_t epoch = published.getEpoch();
+	double aloneNs = measure(writerFrame, PUBLISH_FRAMES);
+	uint64_t aloneCopies = published.getEpoch() - epoch;
+
+	std::atomic<bool> stopping{ false };
+	std::atomic<uint32_t> ready{ 0 };
+	std::atomic<uint64_t> queries{ 0 }, torn{ 0 };
+	std::vector<std::thread> readers;
+	for (uint32_t r = 0; r < PUBLISH_READERS; r++) {
+		readers.emplace_back([&, r]() {
+			int slot = published.acquireSlot();
+			ready++;
+			Lcg local = { 12345 + r };
+			std::vector<Geometry*> results;
+			while (slot >= 0 && !stopping.load()) {
+				PublishedIndex::Pin pin(published, slot);
+				if (!pin.get()) {
+					continue;
+				}
+				results.clear();
+				pin->queryRect(corner, results);
+				torn += results.size() != 0 && results.size() != PUBLISH_BATCH;
+				Point2d p(local.next(QUERY_WORLD_SIZE), local.next(QUERY_WORLD_SIZE));
+				results.clear();
+				pin->queryCircle(p, 200, results);
+				queries += 2;
+			}
+			if (slot >= 0) {
+				published.releaseSlot(slot);
+			}
+		});
+	}
+	while (ready.load() < PUBLISH_READERS) {
+		std::this_thread::yield();
+	}
+	epoch = published.getEpoch();
+	double readNs = measure(writerFrame, PUBLISH_FRAMES);
+	uint64_t readCopies = published.getEpoch() - epoch;
+	stopping = true;
+	for (std::thread& t : readers) {
+		t.join();
+	}
+	published.reclaim();
+
+	std::stringstream s;
+	s << std::fixed << std::setprecision(1) << "published index\t" << (torn.load() == 0 && aloneCopies == 0 && readCopies == PUBLISH_FRAMES ? "pass" : "FAIL")
+		<< "\tframe with no reader " << aloneNs / 1e3 << "us (" << aloneCopies << " copies)\twith " << PUBLISH_READERS << " readers " << readNs / 1e3 << "us ("
+		<< readCopies << " copies)\t" << queries.load() << " reader queries, " << torn.load() << " saw part of a batch\t" << published.getRetiredCount() << " copies left retired\n";
+	report(s.str());
+
+	for (Geometry* g : scene) {
+		delete g;
+	}
+	for (Geometry* g : batch) {
+		delete g;
+	}
+}
+
+void Benchmark::spatialIndexes() {
+	Lcg lcg;
+	// Pseudo random across the whole sparse world, which 24 bits of the generator cannot reach alone
+	auto wide = [&lcg](uint32_t range) { return (uint32_t)(((uint64_t)lcg.next(1 << 16) << 16 | lcg.next(1 << 16)) % range); };
+	uint32_t count = QUERY_SCENE_SIZES[1];
+	const char* names[] = { "dense", "sparse" };
+	for (int sparse = 0; sparse < 2; sparse++) {
+		// The sparse scene packs the same shapes into 64 clusters the size of the dense world's sixteenth
+		uint32_t clusterSize = QUERY_WORLD_SIZE / 4;
+		std::vector<Point2d> clusters;
+		for (int c = 0; c < 64; c++) {
+			clusters.push_back(sparse ? Point2d(wide(INDEX_SPARSE_WORLD_SIZE - clusterSize), wide(INDEX_SPARSE_WORLD_SIZE - clusterSize)) : Point2d(0, 0));
+		}
+		uint32_t range = sparse ? clusterSize : QUERY_WORLD_SIZE;
+		auto place = [&](uint32_t i, uint32_t margin) {
+			const Point2d& origin = clusters[i % clusters.size()];
+			return Point2d(origin.x + lcg.next(range - margin), origin.y + lcg.next(range - margin));
+		};
+		IndexWorkload w;
+		for (uint32_t i = 0; i < count; i++) {
+			Point2d p = place(i, 64);
+			w.scene.push_back(new Line(p, Point2d(p.x + lcg.next(64), p.y + lcg.next(64))));
+		}
+		for (uint32_t i = 0; i < QUERY_ITERATIONS; i++) {
+			Point2d p = place(i, 2000);
+			w.regions.push_back(BoundingBox(p.x, p.y, p.x + 800, p.y + 600));
+			w.segments.push_back(std::make_pair(p, Point2d(p.x + lcg.next(2000), p.y + lcg.next(2000))));
+			w.points.push_back(place(i, 0));
+			BinaryAngle from = BinaryAngle::fromDegrees(lcg.next(360));
+			w.wedges.push_back(Wedge(p, from, from + BinaryAngle::fromDegrees(60), 2000));
+		}
+
+		// The quadtree's answers are the reference every grid must match
+		SpatialIndex* quadtree = new Quadtree(Rect(Point2d(0, 0), sparse ? Point2d(INDEX_SPARSE_WORLD_SIZE, INDEX_SPARSE_WORLD_SIZE) : Point2d(QUERY_WORLD_SIZE, QUERY_WORLD_SIZE)));
+		IndexAnswers expected;
+		report(std::string(names[sparse]) + " " + std::to_string(count) + "\tquadtree\t" + runIndexWorkload(quadtree, w, expected) + "\n");
+		delete quadtree;
+		for (uint32_t cellSize : INDEX_CELL_SIZES) {
+			UniformGrid* grid = new UniformGrid(cellSize);
+			IndexAnswers answers;
+			std::string line = runIndexWorkload(grid, w, answers);
+			delete grid;
+			uint32_t differences = countDifferences(expected, answers);
+			UniformGrid full(cellSize);
+			full.addGeometry(w.scene);
+			UniformGrid::Stats stats = full.getStats();
+			report(std::string(names[sparse]) + " " + std::to_string(count) + "\tgrid " + std::to_string(cellSize) + "\t" + (differences ? "FAIL" : "pass") + "\t" + line
+				+ "\t(" + std::to_string(stats.cells) + " cells, " + std::to_string(stats.entries) + " entries, probe " + std::to_string(stats.longestProbe) + ")\t"
+				+ std::to_string(differences) + " of " + std::to_string(expected.found.size() + expected.nearest.size()) + " answers differ\n");
+		}
+		for (Geometry* g : w.scene) {
+			delete g;
+		}
+	}
+}
+
+void Benchmark::firstPerson() {
+	// Square blocks with streets between them, inside a wall around the whole city
+	const uint32_t block = 200, street = 50, pitch = block + street;
+	std::vector<Geometry*> geometry;
+	for (uint32_t y = 0; y < FIRST_PERSON_BLOCKS; y++) {
+		for (uint32_t x = 0; x < FIRST_PERSON_BLOCKS; x++) {
+			geometry.push_back(new Rect(Point2d(street + x * pitch, street + y * pitch), Point2d(pitch + x * pitch, pitch + y * pitch)));
+		}
+	}
+	uint32_t extent = FIRST_PERSON_BLOCKS * pitch + street;
+	geometry.push_back(new Rect(Point2d(0, 0), Point2d(extent, extent)));
+
+	BspTree bsp;
+	double buildNs = measure([&]() { bsp.build(geometry); }, 1);
+	BspTree::Stats stats = bsp.getStats();
+
+	Lcg lcg;
+	std::vector<Camera> views;
+	for (uint32_t i = 0; i < FIRST_PERSON_VIEWS; i++) {
+		// Halfway across a street running either way, looking in any direction
+		uint32_t along = street + lcg.next(extent - 2 * street), across = lcg.next(FIRST_PERSON_BLOCKS) * pitch + street / 2;
+		views.push_back(i % 2 ? Camera(along, across, (float)lcg.next(360)) : Camera(across, along, (float)lcg.next(360)));
+	}
+
+	// Both passes project walls through the same ColumnProjection, so any column where they differ is a wall the
+	// front to back order or the coverage got wrong
+	ColumnCoverage coverage;
+	std::vector<std::vector<WallColumn>> columns(FIRST_PERSON_VIEWS), nearest(FIRST_PERSON_VIEWS);
+	uint64_t visited = 0;
+	uint32_t i = 0;
+	double bspNs = measure([&]() {
+		coverage.reset(FIRST_PERSON_COLUMNS);
+		visited += bsp.castColumns(views[i], coverage, columns[i]);
+		i++;
+	}, FIRST_PERSON_VIEWS);
+	i = 0;
+	double everyNs = measure([&]() {
+		projectWalls(views[i], geometry, FIRST_PERSON_COLUMNS, nearest[i]);
+		i++;
+	}, FIRST_PERSON_VIEWS);
+	uint32_t mismatched = 0;
+	for (uint32_t v = 0; v < FIRST_PERSON_VIEWS; v++) {
+		for (uint32_t c = 0; c < FIRST_PERSON_COLUMNS; c++) {
+			double expected = nearest[v][c].distance, found = columns[v][c].distance;
+			bool bothEmpty = expected == DBL_MAX && found == DBL_MAX;
+			mismatched += !bothEmpty && fabs(found - expected) > FIRST_PERSON_TOLERANCE * max(1.0, expected);
+		}
+	}
+
+	std::stringstream s;
+	s << std::fixed << std::setprecision(1) << "first person " << geometry.size() * 4 << " walls\tbsp build " << buildNs / 1e6 << "ms (" << stats.nodes << " nodes, "
+		<< stats.splits << " splits, depth " << stats.depth << ")\tfront to back " << bspNs / 1e3 << "us (" << (double)visited / FIRST_PERSON_VIEWS
+		<< " walls visited)\tevery wall " << everyNs / 1e3 << "us\t" << (mismatched ? "FAIL " : "pass ") << mismatched << " of "
+		<< FIRST_PERSON_VIEWS * FIRST_PERSON_COLUMNS << " columns differ\n";
+	report(s.str());
+
+	Quadtree qt(Rect(Point2d(0, 0), Point2d(extent, extent)));
+	qt.addGeometry(geometry);
+	Camera camera = views[0];
+	std::vector<Geometry*> results;
+	size_t found = 0;
+	double wholeNs = measure([&]() {
+		camera.direction += BinaryAngle::fromDegrees(FIRST_PERSON_TURN);
+		results.clear();
+		qt.queryWedge(camera.getViewWedge(FIRST_PERSON_REACH), results);
+		found += results.size();
+	}, 360);
+	camera = views[0];
+	VisibleSet visible;
+	size_t changed = 0;
+	double incrementalNs = measure([&]() {
+		camera.direction += BinaryAngle::fromDegrees(FIRST_PERSON_TURN);
+		visible.update(qt, camera.getViewWedge(FIRST_PERSON_REACH));
+		changed += visible.getAdded().size() + visible.getRemoved().size();
+	}, 360);
+	// Projecting only the walls of the visible set, against the first person pass as Renderer runs it, the BSP over the
+	// whole city cast with column coverage
+	camera = views[0];
+	visible.invalidate();
+	std::vector<WallColumn> fromSet, fromBsp;
+	std::vector<std::vector<WallColumn>> setFrames;
+	double setWallsNs = measure([&]() {
+		camera.direction += BinaryAngle::fromDegrees(FIRST_PERSON_TURN);
+		visible.update(qt, camera.getViewWedge(FIRST_PERSON_REACH));
+		projectWalls(camera, visible.getShapes(), FIRST_PERSON_COLUMNS, fromSet);
+		setFrames.push_back(fromSet);
+	}, 360);
+	camera = views[0];
+	std::vector<std::vector<WallColumn>> bspFrames;
+	double turningBspNs = measure([&]() {
+		camera.direction += BinaryAngle::fromDegrees(FIRST_PERSON_TURN);
+		coverage.reset(FIRST_PERSON_COLUMNS);
+		bsp.castColumns(camera, coverage, fromBsp);
+		bspFrames.push_back(fromBsp);
+	}, 360);
+	// Columns whose wall is within reach must agree. Anything further may be missing from the visible set
+	double halfFov = BinaryAngle::fromDegrees(camera.fov).value * M_PI / BinaryAngle::UNITS_PER_TURN;
+	mismatched = 0;
+	for (size_t f = 0; f < setFrames.size(); f++) {
+		for (uint32_t c = 0; c < FIRST_PERSON_COLUMNS; c++) {
+			double expected = bspFrames[f][c].distance;
+			mismatched += expected < FIRST_PERSON_REACH * cos(halfFov) && fabs(setFrames[f][c].distance - expected) > FIRST_PERSON_TOLERANCE * max(1.0, expected);
+		}
+	}
+	s.str("");
+	s << std::fixed << std::setprecision(1) << "view wedge turning " << FIRST_PERSON_TURN << "deg a frame\twhole query " << wholeNs / 1e3 << "us (" << found / 360.0
+		<< " shapes)\tvisible set " << incrementalNs / 1e3 << "us (" << changed / 360.0 << " added or removed)\tvisible set walls "
+		<< setWallsNs / 1e3 << "us\tbsp pass " << turningBspNs / 1e3 << "us\t" << (mismatched ? "FAIL " : "pass ") << mismatched << " columns differ\n";
+	report(s.str());
+
+	for (Geometry* g : geometry) {
+		delete g;
+	}
+}
+
+void Benchmark::inputLatency() {
+	std::vector<SyntheticInput::Step> script;
+	for (uint32_t i = 0; i < INPUT_EVENTS; i++) {
+		script.push_back({ INPUT_SPACING, W_DOWN, i % 2 == 0 });
+	}
+	InputQueue queue;
+	SyntheticInput source(script);
+	int64_t frameLength = (int64_t)(1e9 / INPUT_FRAME_RATE);
+	int64_t start = InputQueue::now();
+	double queuedNs = 0, polledNs = 0, worstNs = 0;
+	uint32_t received = 0;
+	source.start(queue);
+	// Spin on the queue as a simulation thread would, and work out when a once a frame poll would have seen each event
+	while (received < INPUT_EVENTS && !(source.isFinished() && received + queue.getDropped() >= INPUT_EVENTS)) {
+		InputEvent e;
+		if (!queue.pop(e)) {
+			continue;
+		}
+		double latency = (double)(InputQueue::now() - e.time);
+		queuedNs += latency;
+		worstNs = max(worstNs, latency);
+		polledNs += (double)(frameLength - (e.time - start) % frameLength);
+		received++;
+	}
+	source.stop();
+
+	std::stringstream s;
+	s << std::fixed << std::setprecision(1) << "input latency " << received << " events\tqueued " << queuedNs / max(received, 1u) / 1e3 << "us (worst "
+		<< worstNs / 1e3 << "us)\tpolled at " << INPUT_FRAME_RATE << "fps " << polledNs / max(received, 1u) / 1e6 << "ms\n";
+	report(s.str());
+
+	// Presses of random length starting anywhere in a frame, held time totalled from what each frame saw
+	Camera camera;
+	Input input(&camera);
+	Lcg lcg;
+	double polledError = 0, timedError = 0;
+	int64_t frame = 0;
+	for (uint32_t i = 0; i < INPUT_PRESSES; i++) {
+		int64_t down = frame * frameLength + lcg.next((uint32_t)frameLength), up = down + 1000000 + lcg.next((uint32_t)(frameLength * 4));
+		input.events.push({ down, W_DOWN, true });
+		input.events.push({ up, W_DOWN, false });
+		double polled = 0, timed = 0;
+		for (; frame * frameLength < up; frame++) {
+			input.consumeInput(frame * frameLength, (frame + 1) * frameLength);
+			// Polling applied whatever was held once the frame's messages were drained to the whole frame
+			polled += input.inputState[W_DOWN].held ? frameLength : 0;
+			timed += input.inputState[W_DOWN].heldFor * frameLength;
+		}
+		polledError += fabs(polled - (up - down));
+		timedError += fabs(timed - (up - down));
+	}
+	s.str("");
+	s << std::fixed << std::setprecision(2) << "held time error per press\tpolled " << polledError / INPUT_PRESSES / 1e6 << "ms\ttimestamped "
+		<< timedError / INPUT_PRESSES / 1e6 << "ms\n";
+	report(s.str());
+
+	// The window path: each press as a down and an up message posted during a frame and drained at the start of the
+	// next, stamped at the drain as setInput used to and from the message time as it does now
+	Input posted(&camera);
+	KeyState drained;
+	uint32_t baseTick = (uint32_t)GetTickCount();
+	int64_t base = posted.toQueueTime(baseTick);
+	uint32_t frameMs = (uint32_t)(frameLength / 1000000);
+	double drainedError = 0, postedError = 0, worstPosted = 0;
+	frame = 0;
+	for (uint32_t i = 0; i < INPUT_PRESSES; i++) {
+		// Whole milliseconds from the frame's start, rounded up so that the press is never before the frame draining it
+		uint32_t down = (uint32_t)((frame * frameLength + 999999) / 1000000) + lcg.next(frameMs - 1), up = down + 1 + lcg.next(frameMs * 4);
+		std::pair<uint32_t, bool> messages[] = { { down, true }, { up, false } };
+		double drainedHeld = 0, postedHeld = 0;
+		for (int next = 0; next < 2; frame++) {
+			int64_t from = base + frame * frameLength, to = from + frameLength;
+			for (; next < 2 && base + (int64_t)messages[next].first * 1000000 < to; next++) {
+				MSG msg = {};
+				msg.wParam = 0x57;
+				msg.time = baseTick + messages[next].first;
+				posted.setInput(&msg, messages[next].second);
+				drained.events.push({ to, W_DOWN, messages[next].second });
+			}
+			posted.consumeInput(from, to);
+			drained.consumeInput(from, to);
+			postedHeld += posted.inputState[W_DOWN].heldFor * frameLength;
+			drainedHeld += drained.inputState[W_DOWN].heldFor * frameLength;
+		}
+		double held = (double)(up - down) * 1000000;
+		drainedError += fabs(drainedHeld - held);
+		postedError += fabs(postedHeld - held);
+		worstPosted = max(worstPosted, fabs(postedHeld - held));
+	}
+	s.str("");
+	s << std::fixed << std::setprecision(2) << "window messages\t" << (worstPosted <= INPUT_MESSAGE_TOLERANCE ? "pass" : "FAIL") << "\theld time error per press\tstamped at drain "
+		<< drainedError / INPUT_PRESSES / 1e6 << "ms\tfrom message time " << postedError / INPUT_PRESSES / 1e6 << "ms (worst " << worstPosted / 1e6 << "ms)\n";
+	report(s.str());
+
+	// The whole path with no window, a synthetic patrol consumed frame by frame as the main loop does
+	KeyState keys;
+	SyntheticInput patrol(SyntheticInput::patrol(INPUT_HOLD, INPUT_HOLD / 4));
+	double held[KEY_SIZE] = {};
+	uint32_t frames = keys.replay(patrol, frameLength, [&]() {
+		for (int k = 0; k < KEY_SIZE; k++) {
+			held[k] += keys.inputState[k].heldFor * frameLength;
+		}
+	});
+	double worstHeld = 0;
+	for (uint8_t k : { W_DOWN, A_DOWN, S_DOWN, D_DOWN }) {
+		worstHeld = max(worstHeld, fabs(held[k] - INPUT_HOLD));
+	}
+	s.str("");
+	s << std::fixed << std::setprecision(2) << "windowless patrol\t" << (worstHeld <= INPUT_HOLD_TOLERANCE ? "pass" : "FAIL") << "\t" << frames
+		<< " frames\tworst held time error " << worstHeld / 1e6 << "ms of " << INPUT_HOLD / 1e6 << "ms\n";
+	report(s.str());
+}
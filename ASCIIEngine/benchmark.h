@@ -0,0 +1,99 @@
+#ifndef ASCIIENGINE_BENCHMARK_H_
+#define ASCIIENGINE_BENCHMARK_H_
+
+#include <Windows.h>
+#include <stdint.h>
+#include <string>
+#include "geometry.h"
+
+// In-engine timing runs, triggered from debug keys and reported through the BENCHMARK debug type
+namespace Benchmark {
+
+	const uint32_t DEFAULT_ITERATIONS = 100000;
+
+	// Time a callable over a number of iterations, returning the mean cost of one call in nanoseconds
+	template <typename F>
+	double measure(F f, uint32_t iterations = DEFAULT_ITERATIONS) {
+		LARGE_INTEGER begin, end, frequency;
+		QueryPerformanceFrequency(&frequency);
+		QueryPerformanceCounter(&begin);
+		for (uint32_t i = 0; i < iterations; i++) {
+			f();
+		}
+		QueryPerformanceCounter(&end);
+		return (double)(end.QuadPart - begin.QuadPart) * 1e9 / ((double)frequency.QuadPart * iterations);
+	}
+
+	void report(const std::string& line);
+
+	// F1: projection slide solver against the angle based response it replaced, on a flat wall, shallow angles and corners.
+	// Each case also checks the solver's result, reporting pass or FAIL
+	void collisionResponse();
+	// F2: write a level of LEVEL_SEGMENTS random lines in the binary format, then time loading it back. Then time startup
+	// to a first window sized query over STARTUP_SHAPES short walls, loading a level and building the quadtree against
+	// opening a snapshot and querying its own grid
+	const uint32_t LEVEL_SEGMENTS = 1000000;
+	const uint32_t STARTUP_SHAPES = 1000000;
+	const uint32_t STARTUP_WORLD_SIZE = 1 << 16;
+	void levelImport();
+	// F4: quadtree queries against a linear scan of every shape, for a scene of each size in QUERY_SCENE_SIZES
+	const uint32_t QUERY_SCENE_SIZES[] = { 10, 100000 };
+	const uint32_t QUERY_WORLD_SIZE = 1 << 16;
+	const uint32_t QUERY_ITERATIONS = 1000;
+	const uint32_t QUERY_POINTS = 1000;
+	void spatialQueries();
+	// F5: pointer quadtree against the Morton ordered linear quadtree, built from and queried over LINEAR_POINTS points. The
+	// linear tree is also saved and loaded again, and FAIL is reported unless all three find the same shapes in every region
+	const uint32_t LINEAR_POINTS = 1000000;
+	void linearQuadtree();
+	// F6: quadtree shape and query cost at each bucket capacity, over a tiled scene whose rects share corners and edges
+	const uint32_t TUNING_CAPACITIES[] = { 1, 2, 4, 8, 16, 32, 64 };
+	const uint32_t TUNING_SHAPES = 100000;
+	void quadtreeTuning();
+	// F7: replace a selection of BATCH_SELECTION shapes in a QUERY_SCENE_SIZES sized scene, shape by shape and as one update
+	const uint32_t BATCH_SELECTION = 10000;
+	void batchUpdate();
+	// F7 also: PUBLISH_READERS threads query published copies of a QUERY_SCENE_SIZES sized quadtree while the writer adds
+	// and removes a batch of PUBLISH_BATCH shapes each frame, for PUBLISH_FRAMES frames with no reader and then with them.
+	// Reports FAIL if any reader sees part of a batch. Run under a thread or address sanitizer to check the reclamation
+	const uint32_t PUBLISH_READERS = 4;
+	const uint32_t PUBLISH_BATCH = 64;
+	const uint32_t PUBLISH_FRAMES = 500;
+	void publishedReaders();
+	// F8: quadtree and uniform grids of each size in INDEX_CELL_SIZES run the same insert, query and remove workload, over
+	// a dense scene filling the world and a sparse one of clusters spread across INDEX_SPARSE_WORLD_SIZE. Every query is
+	// answered again before and after the removals, and each grid reports FAIL unless its answers match the quadtree's
+	const uint32_t INDEX_CELL_SIZES[] = { 16, 64, 256 };
+	const uint32_t INDEX_SPARSE_WORLD_SIZE = 1 << 28;
+	void spatialIndexes();
+	// F9: first person walls found through the BSP and column coverage, as the first person pass finds them, against
+	// projecting every wall in a city of FIRST_PERSON_BLOCKS square blocks, from FIRST_PERSON_VIEWS viewpoints along its
+	// streets. Reports FAIL unless every column's distance agrees between the two within FIRST_PERSON_TOLERANCE. Then the
+	// shapes in view of a camera turning FIRST_PERSON_TURN degrees a frame, queried whole each frame and kept as a
+	// visible set, and projecting only the walls of that set against the BSP pass
+	const uint32_t FIRST_PERSON_BLOCKS = 200;
+	const uint32_t FIRST_PERSON_VIEWS = 100;
+	const uint32_t FIRST_PERSON_COLUMNS = 120;
+	const uint32_t FIRST_PERSON_REACH = 4096;
+	const double FIRST_PERSON_TOLERANCE = 1e-6; // Relative, beyond a distance of one
+	const double FIRST_PERSON_TURN = 1;
+	void firstPerson();
+	// F11: time from a key change being stamped to a consumer spinning on the queue seeing it, for INPUT_EVENTS changes
+	// replayed by a synthetic source INPUT_SPACING nanoseconds apart, against polling once a frame at INPUT_FRAME_RATE.
+	// This measures queueing only, not input-to-motion latency: the main loop still consumes once a frame, so the camera
+	// moves no sooner. Then the error in held time over INPUT_PRESSES random presses, counted per frame and per event,
+	// and again with each press as window messages drained a frame late, stamped at the drain and from the message
+	// time. FAIL unless every press stamped from its message time is within INPUT_MESSAGE_TOLERANCE. Last, a patrol
+	// holding each key for INPUT_HOLD nanoseconds run through the windowless KeyState::replay, reporting FAIL unless
+	// the held time totalled over its frames is within INPUT_HOLD_TOLERANCE of that for every key
+	const uint32_t INPUT_EVENTS = 200;
+	const int64_t INPUT_SPACING = 1000000;
+	const double INPUT_FRAME_RATE = 60;
+	const uint32_t INPUT_PRESSES = 10000;
+	const int64_t INPUT_HOLD = 50000000;
+	const int64_t INPUT_HOLD_TOLERANCE = 5000000;
+	const int64_t INPUT_MESSAGE_TOLERANCE = 1000000; // Message times are in whole milliseconds
+	void inputLatency();
+};
+
+#endif
@@ -0,0 +1,52 @@
+#include "binary_angle.h"
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+// Anonymous namespace to hide the lookup table
+namespace {
+	// 4096 samples per turn, the remaining 4 bits of the angle interpolate between neighbouring samples
+	const int TABLE_BITS = 12;
+	const int FRACTION_BITS = 16 - TABLE_BITS;
+	const int TABLE_SIZE = 1 << TABLE_BITS;
+
+	struct SineTable {
+		double samples[TABLE_SIZE + 1];
+
+		SineTable() {
+			for (int i = 0; i <= TABLE_SIZE; i++) {
+				samples[i] = ::sin(2 * M_PI * i / TABLE_SIZE);
+			}
+			// Pin the quarter turns so that axis aligned angles are exact
+			samples[0] = 0.0; samples[TABLE_SIZE / 4] = 1.0; samples[TABLE_SIZE / 2] = 0.0; samples[3 * TABLE_SIZE / 4] = -1.0; samples[TABLE_SIZE] = 0.0;
+		}
+	};
+
+	const SineTable sineTable;
+
+	double lookupSine(uint16_t value) {
+		int index = value >> FRACTION_BITS;
+		int fraction = value & ((1 << FRACTION_BITS) - 1);
+		double a = sineTable.samples[index];
+		double b = sineTable.samples[index + 1];
+		return a + (b - a) * fraction / (1 << FRACTION_BITS);
+	}
+}
+
+BinaryAngle BinaryAngle::fromDegrees(double degrees) {
+	// Round to the nearest unit, then let the cast to 16 bits wrap negative and oversized angles
+	int64_t units = (int64_t)floor(degrees * UNITS_PER_TURN / 360.0 + 0.5);
+	return BinaryAngle((uint16_t)(units & 0xFFFF));
+}
+
+double BinaryAngle::sin() const {
+	return lookupSine(value);
+}
+
+double BinaryAngle::cos() const {
+	return lookupSine((uint16_t)(value + QUARTER_TURN));
+}
+
+void BinaryAngle::sincos(double& s, double& c) const {
+	s = lookupSine(value);
+	c = lookupSine((uint16_t)(value + QUARTER_TURN));
+}
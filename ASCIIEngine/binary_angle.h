@@ -0,0 +1,40 @@
+#ifndef ASCIIENGINE_BINARY_ANGLE_H_
+#define ASCIIENGINE_BINARY_ANGLE_H_
+
+#include <stdint.h>
+
+// Angle stored as a fraction of a full turn in 16 bits. Sums and differences wrap through unsigned overflow,
+// so the value never needs clamping back into range, and sin/cos come from a lookup table instead of libm
+class BinaryAngle {
+
+public:
+	static const uint32_t UNITS_PER_TURN = 65536;
+	static const uint16_t QUARTER_TURN = 16384;
+	static const uint16_t HALF_TURN = 32768;
+
+	uint16_t value;
+
+	BinaryAngle() { value = 0; };
+	explicit BinaryAngle(uint16_t p_value) { value = p_value; };
+
+	static BinaryAngle fromDegrees(double degrees);
+	double toDegrees() const { return value * 360.0 / UNITS_PER_TURN; };
+
+	BinaryAngle operator + (BinaryAngle const& obj) const { return BinaryAngle((uint16_t)(value + obj.value)); };
+	BinaryAngle operator - (BinaryAngle const& obj) const { return BinaryAngle((uint16_t)(value - obj.value)); };
+	BinaryAngle operator - () const { return BinaryAngle((uint16_t)(0 - value)); };
+	BinaryAngle& operator += (BinaryAngle const& obj) { value = (uint16_t)(value + obj.value); return *this; };
+	BinaryAngle& operator -= (BinaryAngle const& obj) { value = (uint16_t)(value - obj.value); return *this; };
+
+	bool operator == (BinaryAngle const& obj) const { return value == obj.value; };
+	bool operator != (BinaryAngle const& obj) const { return value != obj.value; };
+
+	// Signed shortest rotation from obj to this angle, in the range [-HALF_TURN, HALF_TURN)
+	int16_t differenceFrom(BinaryAngle const& obj) const { return (int16_t)(uint16_t)(value - obj.value); };
+
+	double sin() const;
+	double cos() const;
+	void sincos(double& s, double& c) const;
+};
+
+#endif
@@ -0,0 +1,304 @@
+#include "bsp_tree.h"
+#include <cfloat>
+#include <utility>
+
+// Anonymous namespace to hide internal helper functions
+namespace {
+	// Signed distance of (x, y) from a partition, positive in front
+	double sideOf(double a, double b, double c, double x, double y) {
+		return a * x + b * y + c;
+	}
+
+	// Calls wall(g, from, to) for every wall of g: a line's single side, or the closed ring around any other shape's
+	// vertices. Sides of no length are skipped
+	template <typename Wall>
+	void forEachWall(Geometry* g, Wall wall) {
+		size_t size = g->vertices.size();
+		auto side = [&](size_t from, size_t to) {
+			if (g->vertices[from] != g->vertices[to]) {
+				wall(from, to);
+			}
+		};
+		if (g->type == Geometry::G_LINE) {
+			if (size >= 2) {
+				side(0, 1);
+			}
+			return;
+		}
+		// A circle's first vertex is its centre, followed by the corners of its outline
+		size_t begin = g->type == Geometry::G_CIRCLE ? 1 : 0;
+		if (size < begin + 3) {
+			return;
+		}
+		for (size_t i = begin; i < size; i++) {
+			side(i, i + 1 < size ? i + 1 : begin);
+		}
+	}
+
+	void appendWalls(Geometry* g, std::vector<BspTree::Segment>& list) {
+		forEachWall(g, [&](size_t from, size_t to) {
+			const Point2d& p0 = g->vertices[from];
+			const Point2d& p1 = g->vertices[to];
+			list.push_back({ (double)p0.x, (double)p0.y, (double)p1.x, (double)p1.y, g, (int16_t)from });
+		});
+	}
+}
+
+void ColumnCoverage::reset(uint32_t columns) {
+	next.resize(columns + 1);
+	for (uint32_t i = 0; i <= columns; i++) {
+		next[i] = i;
+	}
+	remaining = columns;
+}
+
+uint32_t ColumnCoverage::findUncovered(uint32_t column) {
+	if (column >= next.size()) {
+		return size();
+	}
+	// Path halving: every link followed is pointed past the one after it
+	while (next[column] != column) {
+		next[column] = next[next[column]];
+		column = next[column];
+	}
+	return column;
+}
+
+void BspTree::clear() {
+	nodes.clear();
+	segments.clear();
+	stats = Stats();
+}
+
+void BspTree::build(const std::vector<Geometry*>& geometry) {
+	clear();
+	std::vector<Segment> all;
+	for (Geometry* g : geometry) {
+		appendWalls(g, all);
+	}
+	if (all.empty()) {
+		return;
+	}
+	segments.reserve(all.size());
+
+	// Each pending node carries the walls left to place beneath it
+	struct Pending {
+		uint32_t node;
+		uint32_t depth;
+		std::vector<Segment> list;
+	};
+	std::vector<Pending> open;
+	nodes.push_back(Node());
+	open.push_back({ 0, 1, std::move(all) });
+	while (!open.empty()) {
+		Pending pending = std::move(open.back());
+		open.pop_back();
+		stats.depth = max(stats.depth, pending.depth);
+
+		const Segment& splitter = pending.list[chooseSplitter(pending.list)];
+		double dx = splitter.x1 - splitter.x0, dy = splitter.y1 - splitter.y0;
+		double length = sqrt(dx * dx + dy * dy);
+		double a = -dy / length, b = dx / length;
+		double c = -(a * splitter.x0 + b * splitter.y0);
+
+		std::vector<Segment> front, back;
+		uint32_t first = (uint32_t)segments.size();
+		BoundingBox bounds;
+		for (const Segment& s : pending.list) {
+			bounds.include(Point2d((uint32_t)s.x0, (uint32_t)s.y0));
+			bounds.include(Point2d((uint32_t)ceil(s.x0), (uint32_t)ceil(s.y0)));
+			bounds.include(Point2d((uint32_t)s.x1, (uint32_t)s.y1));
+			bounds.include(Point2d((uint32_t)ceil(s.x1), (uint32_t)ceil(s.y1)));
+			double d0 = sideOf(a, b, c, s.x0, s.y0), d1 = sideOf(a, b, c, s.x1, s.y1);
+			bool on0 = fabs(d0) <= EPSILON, on1 = fabs(d1) <= EPSILON;
+			if (on0 && on1) {
+				segments.push_back(s);
+			} else if (d0 >= -EPSILON && d1 >= -EPSILON) {
+				front.push_back(s);
+			} else if (d0 <= EPSILON && d1 <= EPSILON) {
+				back.push_back(s);
+			} else {
+				// Cut where the wall crosses the partition, each piece keeping the wall it came from
+				double t = d0 / (d0 - d1);
+				double mx = s.x0 + t * (s.x1 - s.x0), my = s.y0 + t * (s.y1 - s.y0);
+				Segment head = { s.x0, s.y0, mx, my, s.g, s.edge };
+				Segment tail = { mx, my, s.x1, s.y1, s.g, s.edge };
+				(d0 > 0 ? front : back).push_back(head);
+				(d1 > 0 ? front : back).push_back(tail);
+				stats.splits++;
+			}
+		}
+		Node& node = nodes[pending.node];
+		node.a = a;
+		node.b = b;
+		node.c = c;
+		node.bounds = bounds;
+		node.first = first;
+		node.count = (uint32_t)segments.size() - first;
+		// Children are created before being filled, so node may move with the pool and is not used past here
+		if (!front.empty()) {
+			nodes[pending.node].front = (uint32_t)nodes.size();
+			nodes.push_back(Node());
+			open.push_back({ nodes[pending.node].front, pending.depth + 1, std::move(front) });
+		}
+		if (!back.empty()) {
+			nodes[pending.node].back = (uint32_t)nodes.size();
+			nodes.push_back(Node());
+			open.push_back({ nodes[pending.node].back, pending.depth + 1, std::move(back) });
+		}
+	}
+	stats.nodes = (uint32_t)nodes.size();
+	stats.segments = (uint32_t)segments.size();
+}
+
+uint32_t BspTree::chooseSplitter(const std::vector<Segment>& list) const {
+	// Candidates and the walls they are scored against are both spread evenly through the list, so the cost of a
+	// choice stays fixed however many walls remain beneath the node
+	uint32_t n = (uint32_t)list.size();
+	uint32_t candidates = min(n, SPLITTER_CANDIDATES), sample = min(n, SCORE_SAMPLE);
+	uint32_t best = 0;
+	double bestScore = DBL_MAX;
+	for (uint32_t i = 0; i < candidates; i++) {
+		uint32_t index = (uint32_t)((uint64_t)i * n / candidates);
+		const Segment& splitter = list[index];
+		double dx = splitter.x1 - splitter.x0, dy = splitter.y1 - splitter.y0;
+		double length = sqrt(dx * dx + dy * dy);
+		double a = -dy / length, b = dx / length;
+		double c = -(a * splitter.x0 + b * splitter.y0);
+		uint32_t front = 0, back = 0, splits = 0;
+		for (uint32_t j = 0; j < sample; j++) {
+			const Segment& s = list[(uint32_t)((uint64_t)j * n / sample)];
+			double d0 = sideOf(a, b, c, s.x0, s.y0), d1 = sideOf(a, b, c, s.x1, s.y1);
+			if (fabs(d0) <= EPSILON && fabs(d1) <= EPSILON) {
+				continue;
+			} else if (d0 >= -EPSILON && d1 >= -EPSILON) {
+				front++;
+			} else if (d0 <= EPSILON && d1 <= EPSILON) {
+				back++;
+			} else {
+				splits++;
+			}
+		}
+		double score = splits * SPLIT_COST + abs((int64_t)front - (int64_t)back);
+		if (score < bestScore) {
+			bestScore = score;
+			best = index;
+		}
+	}
+	return best;
+}
+
+uint32_t BspTree::castColumns(const Camera& camera, ColumnCoverage& coverage, std::vector<WallColumn>& columns) const {
+	uint32_t count = coverage.size();
+	columns.assign(count, { DBL_MAX, nullptr, -1 });
+	if (count == 0) {
+		return 0;
+	}
+	ColumnProjection projection(camera, count);
+	// A subtree is skipped once the view is full or its bounds are wholly outside the view wedge
+	auto enter = [&](const BoundingBox& box) {
+		return !coverage.isFull() && projection.meets(box);
+	};
+	uint32_t visited = 0;
+	auto visit = [&](const Segment& s) {
+		visited++;
+		ColumnProjection::Wall wall;
+		if (projection.project(s.x0, s.y0, s.x1, s.y1, wall)) {
+			coverage.cover(wall.first, wall.last, [&](uint32_t column) {
+				columns[column] = { projection.distanceAt(wall, column), s.g, s.edge };
+			});
+		}
+		return !coverage.isFull();
+	};
+	traverse(camera.x, camera.y, enter, visit);
+	return visited;
+}
+
+ColumnProjection::ColumnProjection(const Camera& camera, uint32_t p_columns) {
+	px = camera.x;
+	py = camera.y;
+	camera.direction.sincos(dirY, dirX);
+	halfFov = BinaryAngle::fromDegrees(camera.fov).value * M_PI / BinaryAngle::UNITS_PER_TURN;
+	halfSin = sin(halfFov);
+	halfCos = cos(halfFov);
+	columns = p_columns;
+	step = columns ? 2 * halfFov / columns : 0;
+}
+
+bool ColumnProjection::project(double x0, double y0, double x1, double y1, Wall& wall) const {
+	x0 -= px; y0 -= py; x1 -= px; y1 -= py;
+	double depth0 = x0 * dirX + y0 * dirY, across0 = y0 * dirX - x0 * dirY;
+	double depth1 = x1 * dirX + y1 * dirY, across1 = y1 * dirX - x1 * dirY;
+	if (columns == 0 || (depth0 < NEAR_DEPTH && depth1 < NEAR_DEPTH)) {
+		return false;
+	}
+	// Cut away any part behind the viewpoint, so both ends have an angle within a half turn of the view
+	double cut0 = depth0, cut1 = depth1, side0 = across0, side1 = across1;
+	if (cut0 < NEAR_DEPTH) {
+		double t = (NEAR_DEPTH - depth0) / (depth1 - depth0);
+		cut0 = NEAR_DEPTH;
+		side0 = across0 + t * (across1 - across0);
+	} else if (cut1 < NEAR_DEPTH) {
+		double t = (NEAR_DEPTH - depth1) / (depth0 - depth1);
+		cut1 = NEAR_DEPTH;
+		side1 = across1 + t * (across0 - across1);
+	}
+	double angle0 = atan2(side0, cut0), angle1 = atan2(side1, cut1);
+	// Columns whose centres fall within the wall's angular extent
+	double lowest = (min(angle0, angle1) + halfFov) / step - 0.5, highest = (max(angle0, angle1) + halfFov) / step - 0.5;
+	if (highest < 0 || lowest > columns - 1) {
+		return false;
+	}
+	wall.first = (uint32_t)max(0.0, ceil(lowest));
+	wall.last = (uint32_t)min((double)columns - 1, floor(highest));
+	wall.depth0 = depth0;
+	wall.across0 = across0;
+	wall.ex = depth1 - depth0;
+	wall.ey = across1 - across0;
+	wall.nearest = min(cut0, cut1);
+	return wall.first <= wall.last;
+}
+
+double ColumnProjection::distanceAt(const Wall& wall, uint32_t column) const {
+	double angle = -halfFov + (column + 0.5) * step;
+	double rx = cos(angle), ry = sin(angle);
+	// Distance t along the column's ray to the wall, from t * r = p0 + u * e
+	double denominator = rx * wall.ey - ry * wall.ex;
+	double t = fabs(denominator) > 1e-12 ? (wall.depth0 * wall.ey - wall.across0 * wall.ex) / denominator : wall.nearest;
+	return max(t * rx, NEAR_DEPTH);
+}
+
+bool ColumnProjection::meets(const BoundingBox& box) const {
+	bool leftOut = true, rightOut = true;
+	for (int i = 0; i < 4; i++) {
+		double x = (i & 1 ? box.maxX : (double)box.minX) - px, y = (i & 2 ? box.maxY : (double)box.minY) - py;
+		double depth = x * dirX + y * dirY, across = y * dirX - x * dirY;
+		leftOut = leftOut && across * halfCos + depth * halfSin < 0;
+		rightOut = rightOut && depth * halfSin - across * halfCos < 0;
+	}
+	return !leftOut && !rightOut;
+}
+
+uint32_t projectWalls(const Camera& camera, const std::vector<Geometry*>& geometry, uint32_t count, std::vector<WallColumn>& columns) {
+	columns.assign(count, { DBL_MAX, nullptr, -1 });
+	ColumnProjection projection(camera, count);
+	uint32_t projected = 0;
+	for (Geometry* g : geometry) {
+		forEachWall(g, [&](size_t from, size_t to) {
+			projected++;
+			const Point2d& p0 = g->vertices[from];
+			const Point2d& p1 = g->vertices[to];
+			ColumnProjection::Wall wall;
+			if (!projection.project(p0.x, p0.y, p1.x, p1.y, wall)) {
+				return;
+			}
+			for (uint32_t column = wall.first; column <= wall.last; column++) {
+				double distance = projection.distanceAt(wall, column);
+				if (distance < columns[column].distance) {
+					columns[column] = { distance, g, (int16_t)from };
+				}
+			}
+		});
+	}
+	return projected;
+}
@@ -0,0 +1,166 @@
+#ifndef ASCIIENGINE_BSP_TREE_H_
+#define ASCIIENGINE_BSP_TREE_H_
+
+#include <stdint.h>
+#include <vector>
+#include "geometry.h"
+
+// Columns of the first person view still waiting for a wall. Covered columns are skipped in runs by following next
+// links towards the next uncovered column, shortened as they are followed, so covering costs the columns it fills
+class ColumnCoverage {
+
+public:
+	void reset(uint32_t columns);
+	uint32_t size() const { return (uint32_t)next.size() - 1; };
+	bool isFull() const { return remaining == 0; };
+	// Calls fill(column) for every uncovered column from first to last inclusive, then marks them covered
+	template <typename Fill>
+	void cover(uint32_t first, uint32_t last, Fill fill) {
+		for (uint32_t column = findUncovered(first); column <= last && column < size(); column = findUncovered(column + 1)) {
+			fill(column);
+			next[column] = column + 1;
+			remaining--;
+		}
+	};
+
+private:
+	uint32_t findUncovered(uint32_t column); // First uncovered column at or after column, or size() if none
+	std::vector<uint32_t> next; // Itself while uncovered. The extra last entry is an uncovered sentinel
+	uint32_t remaining = 0;
+};
+
+// Nearest wall along one column of the view
+struct WallColumn {
+	double distance; // Perpendicular to the view direction, so walls do not bow towards the edges
+	Geometry* g; // nullptr while nothing has been hit
+	int16_t edge; // Side starting at g->vertices[edge]
+};
+
+// Walls moved into the camera's view space, depth along the view direction and across it towards the last column, and
+// spread over the columns of its view. Columns are spaced evenly in angle across the field of view, as in the first
+// person pass. Shared by every pass that draws walls into columns, so they all compute the same image
+class ColumnProjection {
+
+public:
+	static constexpr double NEAR_DEPTH = 1e-3; // Walls are cut off this far in front of the viewpoint
+
+	// A wall in view space, with the columns whose centre rays meet the part of it past NEAR_DEPTH
+	struct Wall {
+		double depth0, across0; // Start point, before clipping
+		double ex, ey; // Start to end
+		double nearest; // Clipped depth of the nearer end, for a wall lying along a column's ray
+		uint32_t first, last;
+	};
+
+	ColumnProjection(const Camera& camera, uint32_t p_columns);
+	uint32_t size() const { return columns; };
+	// False when the wall meets no column
+	bool project(double x0, double y0, double x1, double y1, Wall& wall) const;
+	double distanceAt(const Wall& wall, uint32_t column) const;
+	// False once every corner of box is outside the same edge of the view wedge
+	bool meets(const BoundingBox& box) const;
+
+private:
+	double px, py;
+	double dirX, dirY;
+	double halfFov, halfSin, halfCos;
+	double step; // Angle between column centres
+	uint32_t columns;
+};
+
+// Fills each of count columns with the nearest of every wall of geometry, by comparing depths rather than by visiting
+// walls in order. Returns how many walls were projected
+uint32_t projectWalls(const Camera& camera, const std::vector<Geometry*>& geometry, uint32_t count, std::vector<WallColumn>& columns);
+
+// Binary space partition of every wall in the scene: lines, and the sides of every other shape. Each node splits the
+// plane along one wall, keeping the walls lying on that line and the walls either side below it. Walls crossing a
+// partition are cut in two, so partitions are chosen to keep those cuts few as well as to keep the two sides even
+class BspTree {
+
+public:
+	static constexpr uint32_t SPLITTER_CANDIDATES = 16; // Walls tried as the partition of each node
+	static constexpr uint32_t SCORE_SAMPLE = 512; // Walls each candidate is scored against, spread through the node
+	static constexpr double SPLIT_COST = 8.0; // Score of one cut wall against one wall of imbalance between the sides
+	static constexpr double EPSILON = 1e-6; // Distance within which an end point lies on a partition
+
+	struct Segment {
+		double x0, y0, x1, y1;
+		Geometry* g;
+		int16_t edge;
+	};
+
+	struct Stats {
+		uint32_t nodes = 0;
+		uint32_t segments = 0; // Including the pieces of cut walls
+		uint32_t splits = 0;
+		uint32_t depth = 0;
+	};
+
+	void build(const std::vector<Geometry*>& geometry);
+	void clear();
+	bool isEmpty() const { return nodes.empty(); };
+	// Calls visit(segment) for every wall, nearest the viewpoint first, until visit returns false. No wall emitted
+	// can be hidden by one emitted after it. Subtrees are skipped whole when enter(bounds) returns false
+	template <typename Enter, typename Visit>
+	void traverse(double px, double py, Enter enter, Visit visit) const;
+	// Fills each column of the view with the first wall it meets, visiting walls front to back only until every
+	// column is covered. Returns how many walls were visited
+	uint32_t castColumns(const Camera& camera, ColumnCoverage& coverage, std::vector<WallColumn>& columns) const;
+	Stats getStats() const { return stats; };
+
+private:
+	static constexpr uint32_t NONE = UINT32_MAX;
+
+	// The partition is the line ax + by + c = 0 with (a, b) a unit normal pointing to the front
+	struct Node {
+		double a, b, c;
+		BoundingBox bounds; // Every wall at or below this node
+		uint32_t first, count; // Walls lying on the partition
+		uint32_t front = NONE;
+		uint32_t back = NONE;
+	};
+
+	uint32_t chooseSplitter(const std::vector<Segment>& list) const;
+
+	std::vector<Node> nodes; // Root first
+	std::vector<Segment> segments;
+	Stats stats;
+};
+
+template <typename Enter, typename Visit>
+void BspTree::traverse(double px, double py, Enter enter, Visit visit) const {
+	if (nodes.empty()) {
+		return;
+	}
+	// Near side, then the walls on the partition, then the far side. The top bit marks a node whose walls are due
+	const uint32_t EMIT = 0x80000000;
+	std::vector<uint32_t> open = { 0 };
+	while (!open.empty()) {
+		uint32_t top = open.back();
+		open.pop_back();
+		const Node& node = nodes[top & ~EMIT];
+		if (top & EMIT) {
+			for (uint32_t s = node.first; s < node.first + node.count; s++) {
+				if (!visit(segments[s])) {
+					return;
+				}
+			}
+			continue;
+		}
+		if (!enter(node.bounds)) {
+			continue;
+		}
+		bool inFront = node.a * px + node.b * py + node.c >= 0;
+		uint32_t nearChild = inFront ? node.front : node.back;
+		uint32_t farChild = inFront ? node.back : node.front;
+		if (farChild != NONE) {
+			open.push_back(farChild);
+		}
+		open.push_back((top & ~EMIT) | EMIT);
+		if (nearChild != NONE) {
+			open.push_back(nearChild);
+		}
+	}
+}
+
+#endif
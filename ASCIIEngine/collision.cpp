@@ -0,0 +1,35 @@
+#include "collision.h"
+
+Shape Collision::toShape(Geometry* g) {
+	switch (g->type) {
+	case (Geometry::G_LINE):
+		return static_cast<Line*>(g);
+	case (Geometry::G_TRI):
+		return static_cast<Tri*>(g);
+	case (Geometry::G_RECT):
+		return static_cast<Rect*>(g);
+	case (Geometry::G_QUAD):
+		return static_cast<Quad*>(g);
+	case (Geometry::G_CIRCLE):
+		return static_cast<Circle*>(g);
+	case (Geometry::G_POLYGON):
+		return static_cast<Poly*>(g);
+	default:
+		return std::monostate();
+	}
+}
+
+void Collision::test(Geometry* a, Geometry* b, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {
+	if (!BroadPhase::test(a->bounds, b->bounds)) {
+		return;
+	}
+	test(toShape(a), toShape(b), collisions, interferingSides);
+}
+
+void Collision::test(const Shape& a, const Shape& b, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {
+	std::visit([&](auto first, auto second) {
+		if constexpr (std::is_pointer_v<decltype(first)> && std::is_pointer_v<decltype(second)>) {
+			testPair(*first, *second, collisions, interferingSides);
+		}
+	}, a, b);
+}
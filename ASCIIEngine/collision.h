@@ -0,0 +1,149 @@
+#ifndef ASCIIENGINE_COLLISION_H_
+#define ASCIIENGINE_COLLISION_H_
+
+#include <type_traits>
+#include <variant>
+#include <vector>
+#include "geometry.h"
+
+// Every concrete shape, held by pointer. Dispatching on a pair of these through std::visit builds the whole
+// pair table at compile time, with each entry an inlined kernel instead of a virtual call and a type switch.
+// Geometry of no known type is held as the empty monostate, which meets nothing
+using Shape = std::variant<std::monostate, Line*, Tri*, Rect*, Quad*, Circle*, Poly*>;
+
+namespace Collision {
+
+	// Shapes whose outline is a chain of straight sides
+	template <typename T> struct IsPolygonal : std::false_type {};
+	template <> struct IsPolygonal<Line> : std::true_type {};
+	template <> struct IsPolygonal<Tri> : std::true_type {};
+	template <> struct IsPolygonal<Rect> : std::true_type {};
+	template <> struct IsPolygonal<Quad> : std::true_type {};
+	template <> struct IsPolygonal<Poly> : std::true_type {};
+
+	// Side i runs from vertex i to vertex i + 1, wrapping for closed shapes. A line is its one open side
+	template <typename T>
+	struct Sides {
+		static int count(const T& g) { return (int)g.vertices.size(); }
+		static const Point2d& start(const T& g, int i) { return g.vertices[i]; }
+		static const Point2d& end(const T& g, int i) { return g.vertices[i + 1 == g.vertices.size() ? 0 : i + 1]; }
+	};
+	template <>
+	struct Sides<Line> {
+		static int count(const Line& g) { return g.vertices.size() == 2 ? 1 : 0; }
+		static const Point2d& start(const Line& g, int i) { return g.vertices[0]; }
+		static const Point2d& end(const Line& g, int i) { return g.vertices[1]; }
+	};
+
+	template <typename A, typename B>
+	struct MissingKernel : std::false_type {};
+
+	// Collects the points where a meets b, along with the side of b at each point. A pair of shapes without a
+	// specialization below fails to compile rather than silently reporting nothing
+	template <typename A, typename B, typename Enable = void>
+	struct Kernel {
+		static_assert(MissingKernel<A, B>::value, "No collision kernel for this pair of shapes");
+		static void apply(const A& a, const B& b, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {}
+	};
+
+	// Segment against segment, for every pair of sides
+	template <typename A, typename B>
+	struct Kernel<A, B, std::enable_if_t<IsPolygonal<A>::value && IsPolygonal<B>::value>> {
+		static void apply(const A& a, const B& b, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {
+			for (int i = 0; i < Sides<A>::count(a); i++) {
+				for (int j = 0; j < Sides<B>::count(b); j++) {
+					Point2d intersection;
+					Line::intersectSegments(Sides<A>::start(a, i), Sides<A>::end(a, i), Sides<B>::start(b, j), Sides<B>::end(b, j), intersection);
+					if (intersection.isInitialized()) {
+						collisions.push_back(intersection);
+						interferingSides.push_back(Line(Sides<B>::start(b, j), Sides<B>::end(b, j)));
+					}
+				}
+			}
+		}
+	};
+
+	// Axis aligned outlines only cross where a vertical side of one meets a horizontal side of the other,
+	// so the crossings fall out of integer comparisons
+	template <>
+	struct Kernel<Rect, Rect> {
+		static void apply(const Rect& a, const Rect& b, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {
+			cross(a, b, collisions, interferingSides, false);
+			cross(b, a, collisions, interferingSides, true);
+		}
+
+	private:
+		static void cross(const Rect& vertical, const Rect& horizontal, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides, bool verticalIsOther) {
+			uint32_t xs[2] = { vertical.lt.x, vertical.rb.x };
+			uint32_t ys[2] = { horizontal.lt.y, horizontal.rb.y };
+			for (uint32_t x : xs) {
+				if (x < horizontal.lt.x || x > horizontal.rb.x) {
+					continue;
+				}
+				for (uint32_t y : ys) {
+					if (y < vertical.lt.y || y > vertical.rb.y) {
+						continue;
+					}
+					collisions.push_back(Point2d(x, y));
+					if (verticalIsOther) {
+						interferingSides.push_back(Line(Point2d(x, vertical.lt.y), Point2d(x, vertical.rb.y)));
+					} else {
+						interferingSides.push_back(Line(Point2d(horizontal.lt.x, y), Point2d(horizontal.rb.x, y)));
+					}
+				}
+			}
+		}
+	};
+
+	// Sides of a against circle b, tested on squared distances before solving for the crossings
+	template <typename A>
+	struct Kernel<A, Circle, std::enable_if_t<IsPolygonal<A>::value>> {
+		static void apply(const A& a, const Circle& b, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {
+			if constexpr (std::is_same_v<A, Rect>) {
+				if (!b.intersectsRect(a)) {
+					return;
+				}
+			}
+			for (int i = 0; i < Sides<A>::count(a); i++) {
+				if (b.intersectsSegment(Sides<A>::start(a, i), Sides<A>::end(a, i))) {
+					b.findIntersections(Sides<A>::start(a, i), Sides<A>::end(a, i), collisions, interferingSides);
+				}
+			}
+		}
+	};
+
+	// Circle a against the sides of b. The crossings are the same either way round, each side reported by its
+	// tangent on the circle
+	template <typename B>
+	struct Kernel<Circle, B, std::enable_if_t<IsPolygonal<B>::value>> {
+		static void apply(const Circle& a, const B& b, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {
+			Kernel<B, Circle>::apply(b, a, collisions, interferingSides);
+		}
+	};
+
+	template <>
+	struct Kernel<Circle, Circle> {
+		static void apply(const Circle& a, const Circle& b, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {
+			if (!a.intersectsCircle(b) || a.center == b.center) {
+				return;
+			}
+			// Report a single contact on the boundary of a, facing the other circle
+			Point2d p = a.findClosestPointOnCircle(b.center);
+			collisions.push_back(p);
+			interferingSides.push_back(a.calculateTangent(p));
+		}
+	};
+
+	// Pair known at compile time, resolved straight to its kernel
+	template <typename A, typename B>
+	void testPair(const A& a, const B& b, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {
+		Kernel<A, B>::apply(a, b, collisions, interferingSides);
+	}
+
+	Shape toShape(Geometry* g);
+	// Pair only known at runtime. One type switch per shape at the boundary, then a single table lookup
+	void test(Geometry* a, Geometry* b, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides);
+	void test(const Shape& a, const Shape& b, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides);
+};
+
+#endif
@@ -6,7 +6,10 @@
 /*  Print flag decoding
 	0
 	b
-	0
+	0 - level import
+	0 - benchmark
+	'
+	0 - broad phase stats
 	0 - quadtree toString
 	0 - quadrant dims
 	0 - quadrant not found
@@ -21,12 +24,12 @@
 	0 - input detected
 	0 - mouse position
 */
-int print = 0b0100'1010'1001;
+int print = 0b0011'0100'1010'1001;
 // storage for print flag to allow toggling
-int stored_print_flag = 0b0000'0000'0000;
+int stored_print_flag = 0b0000'0000'0000'0000;
 
-std::string plainTextCallingClasses[CallingClasses::CLASS_SIZE] = { "main_window", "renderer", "geometry", "input", "quadtree"};
-std::string plainTextDebugTypes[DebugTypes::DEBUG_SIZE] = { "mouse_position", "input_detected", "panel_lock", "geo_queue_mod", "draw_mode_changed", "frames_per_second", "input_status", "camera_status", "quadrant_not_found", "quadrant_dims", "quadtree_tostring"};
+std::string plainTextCallingClasses[CallingClasses::CLASS_SIZE] = { "main_window", "renderer", "geometry", "input", "quadtree", "benchmark"};
+std::string plainTextDebugTypes[DebugTypes::DEBUG_SIZE] = { "mouse_position", "input_detected", "panel_lock", "geo_queue_mod", "draw_mode_changed", "frames_per_second", "input_status", "camera_status", "quadrant_not_found", "quadrant_dims", "quadtree_tostring", "broad_phase_stats", "benchmark", "level_import"};
 #define TAB ":\t"
 #define DTAB ":\t\t"
 
@@ -69,6 +72,10 @@ namespace {
 		{
 			return "CIRCLE";
 		} break;
+		case 5:
+		{
+			return "POLYGON";
+		} break;
 		default:
 			return "UNKNOWN GEOMETRY TYPE";
 		}
@@ -161,7 +168,7 @@ void Debug::Print(Debug::DebugMessage* debugMsg) {
 		case CAMERA_STATUS:
 		{
 			Camera* camera = debugMsg->getCamera();
-			mp += plainTextCallingClasses[caller] + DTAB + plainTextDebugTypes[type] + TAB + " Camera: \tx:" + std::to_string(camera->x) + "\t\t\ty: " + std::to_string(camera->y) + "\t\t\tdir: " + std::to_string(camera->direction) + "\n";
+			mp += plainTextCallingClasses[caller] + DTAB + plainTextDebugTypes[type] + TAB + " Camera: \tx:" + std::to_string(camera->x) + "\t\t\ty: " + std::to_string(camera->y) + "\t\t\tdir: " + std::to_string(camera->direction.toDegrees()) + "\n";
 			mp += "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\tpx: " + std::to_string(camera->px) + "\tpy: " + std::to_string(camera->py) + "\n";
 			mp += "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\tvx: " + std::to_string(camera->vx) + "\tvy: " + std::to_string(camera->vy) + "\n";
 			mp += "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\tax: " + std::to_string(camera->ax) + "\tay: " + std::to_string(camera->ay) + "\n";
@@ -177,7 +184,19 @@ void Debug::Print(Debug::DebugMessage* debugMsg) {
 		case QUADTREE_TOSTRING:
 		{
 			mp += plainTextCallingClasses[caller] + DTAB + plainTextDebugTypes[type] + " Quadtree:\n" + debugMsg->getOutputString();
-		}
+		} break;
+		case BROAD_PHASE_STATS:
+		{
+			mp += plainTextCallingClasses[caller] + DTAB + plainTextDebugTypes[type] + TAB + debugMsg->getOutputString();
+		} break;
+		case BENCHMARK:
+		{
+			mp += plainTextCallingClasses[caller] + DTAB + plainTextDebugTypes[type] + TAB + debugMsg->getOutputString();
+		} break;
+		case LEVEL_IMPORT:
+		{
+			mp += plainTextCallingClasses[caller] + DTAB + plainTextDebugTypes[type] + TAB + debugMsg->getOutputString();
+		} break;
 		}
 		PrintMessage(mp);
 	}
@@ -16,6 +16,7 @@ enum CallingClasses {
 	GEOMETRY_CLASS,
 	INPUT_CLASS,
 	QUADTREE_CLASS,
+	BENCHMARK_CLASS,
 
 	CLASS_SIZE,
 };
@@ -32,6 +33,9 @@ enum DebugTypes {
 	QUADRANT_NOT_FOUND,
 	QUADRANT_DIMS,
 	QUADTREE_TOSTRING,
+	BROAD_PHASE_STATS,
+	BENCHMARK,
+	LEVEL_IMPORT,
 	NONE,
 
 	DEBUG_SIZE,
@@ -6,6 +6,170 @@ void Geometry::createVertexShell() {
 	}
 }
 
+double BoundingBox::distanceSquared(const Point2d& p) const {
+	double dx = p.x < minX ? (double)minX - p.x : (p.x > maxX ? (double)p.x - maxX : 0);
+	double dy = p.y < minY ? (double)minY - p.y : (p.y > maxY ? (double)p.y - maxY : 0);
+	return dx * dx + dy * dy;
+}
+
+// Slab test of the segment against the closed box
+bool BoundingBox::meetsSegment(const Point2d& p0, const Point2d& p1) const {
+	double t0 = 0, t1 = 1;
+	double origin[2] = { (double)p0.x, (double)p0.y };
+	double direction[2] = { (double)p1.x - p0.x, (double)p1.y - p0.y };
+	double lower[2] = { (double)minX, (double)minY };
+	double upper[2] = { (double)maxX, (double)maxY };
+	for (int i = 0; i < 2; i++) {
+		if (direction[i] == 0) {
+			if (origin[i] < lower[i] || origin[i] > upper[i]) {
+				return false;
+			}
+			continue;
+		}
+		double enter = (lower[i] - origin[i]) / direction[i];
+		double leave = (upper[i] - origin[i]) / direction[i];
+		if (enter > leave) {
+			std::swap(enter, leave);
+		}
+		t0 = max(t0, enter);
+		t1 = min(t1, leave);
+		if (t0 > t1) {
+			return false;
+		}
+	}
+	return true;
+}
+
+Wedge::Wedge(const Point2d& p_apex, BinaryAngle p_from, BinaryAngle p_to, uint32_t p_reach) {
+	apex = p_apex;
+	from = p_from;
+	to = p_to;
+	reach = p_reach;
+	from.sincos(fromY, fromX);
+	to.sincos(toY, toX);
+	calculateBounds();
+}
+
+bool Wedge::meets(const BoundingBox& b) const {
+	if (!bounds.overlaps(b) || b.distanceSquared(apex) > (double)reach * reach) {
+		return false;
+	}
+	// Separated when every corner is past the line of the from ray, against the sweep, past the line of the to ray,
+	// or behind the apex. The wedge is under a half turn wide, so lies wholly in front of the apex along its bisector
+	double midX = fromX + toX, midY = fromY + toY;
+	bool beforeFrom = true, beyondTo = true, behind = true;
+	for (int i = 0; i < 4; i++) {
+		double x = (double)(i & 1 ? b.maxX : b.minX) - apex.x, y = (double)(i & 2 ? b.maxY : b.minY) - apex.y;
+		beforeFrom = beforeFrom && fromX * y - fromY * x < 0;
+		beyondTo = beyondTo && x * toY - y * toX < 0;
+		behind = behind && x * midX + y * midY < 0;
+	}
+	return !beforeFrom && !beyondTo && !behind;
+}
+
+void Wedge::calculateBounds() {
+	// The apex, the ends of both rays, and wherever the arc between them crosses an axis
+	double minX = apex.x, minY = apex.y, maxX = apex.x, maxY = apex.y;
+	double ends[4][2] = { { fromX, fromY }, { toX, toY }, { 0, 0 }, { 0, 0 } };
+	int count = 2;
+	for (uint32_t quarter = 0; quarter < 4; quarter++) {
+		BinaryAngle axis((uint16_t)(quarter * BinaryAngle::QUARTER_TURN));
+		if (count < 4 && containsAngle(axis)) {
+			ends[count][0] = quarter == 0 ? 1 : (quarter == 2 ? -1 : 0);
+			ends[count][1] = quarter == 1 ? 1 : (quarter == 3 ? -1 : 0);
+			count++;
+		}
+	}
+	for (int i = 0; i < count; i++) {
+		double x = apex.x + ends[i][0] * reach, y = apex.y + ends[i][1] * reach;
+		minX = min(minX, x);
+		minY = min(minY, y);
+		maxX = max(maxX, x);
+		maxY = max(maxY, y);
+	}
+	bounds = BoundingBox((uint32_t)max(0.0, floor(minX)), (uint32_t)max(0.0, floor(minY)), (uint32_t)min((double)UINT32_MAX, ceil(maxX)), (uint32_t)min((double)UINT32_MAX, ceil(maxY)));
+}
+
+BroadPhase::Stats BroadPhase::stats;
+
+bool BroadPhase::test(const BoundingBox& a, const BoundingBox& b) {
+	stats.tests++;
+	if (a.overlaps(b)) {
+		return true;
+	}
+	stats.rejects++;
+	return false;
+}
+
+void BroadPhase::reset() {
+	stats = Stats();
+}
+
+std::string BroadPhase::toString() {
+	double rate = stats.tests ? 100.0 * stats.rejects / stats.tests : 0.0;
+	std::ostringstream output;
+	output << "tests: " << stats.tests << " || rejects: " << stats.rejects << " || reject rate: " << std::fixed << std::setprecision(1) << rate << "%\n";
+	return output.str();
+}
+
+void Geometry::calculateBounds() {
+	bounds = BoundingBox();
+	for (const Point2d& v : vertices) {
+		bounds.include(v);
+	}
+}
+
+void Geometry::calculateEdgeEquations() {
+	edges.clear();
+	if (vertices.size() < 3) {
+		return;
+	}
+	// Signed area decides winding, so that every edge can be flipped to face the interior
+	int64_t area = 0;
+	for (int i = 0; i < vertices.size(); i++) {
+		const Point2d& p0 = vertices.at(i);
+		const Point2d& p1 = vertices.at(i + 1 == vertices.size() ? 0 : i + 1);
+		area += (int64_t)p0.x * p1.y - (int64_t)p1.x * p0.y;
+	}
+	for (int i = 0; i < vertices.size(); i++) {
+		EdgeEquation e = EdgeEquation(vertices.at(i), vertices.at(i + 1 == vertices.size() ? 0 : i + 1));
+		if (area < 0) {
+			e.a = -e.a; e.b = -e.b; e.c = -e.c;
+		}
+		edges.push_back(e);
+	}
+}
+
+bool Geometry::checkEdgeEquations(const Point2d& p) const {
+	if (edges.empty()) {
+		return false;
+	}
+	for (const EdgeEquation& e : edges) {
+		if (e.evaluate(p) < 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void Geometry::containsPoints(const std::vector<Point2d>& points, std::vector<uint8_t>& results) {
+	results.assign(points.size(), edges.empty() ? 0 : 1);
+	// Edge-major order keeps one equation in registers while streaming over the points
+	for (const EdgeEquation& e : edges) {
+		for (size_t i = 0; i < points.size(); i++) {
+			results[i] &= (uint8_t)(e.evaluate(points[i]) >= 0);
+		}
+	}
+}
+
+void Geometry::containsPoint(const std::vector<Geometry*>& geometry, const Point2d& p, std::vector<Geometry*>& hits) {
+	for (Geometry* g : geometry) {
+		if (g->checkCollisionWith(p)) {
+			hits.push_back(g);
+		}
+	}
+}
+
 /*
 * Take in a binary mask compare type and perform the associated comparison of geometry coordinates.
 * Returns -1 indicating that the coordinate specified in the compare type for the first point is the same as that of the second
@@ -90,48 +254,40 @@ uint8_t Geometry::comparePointPairByCoordinates(const Point2d* p1, const Point2d
 	return result;
 }
 
-bool Geometry::compareBySlope(const float f1, float f2) {
-
-	// return indicates if floats are in their correct positions in vector
-	if (f1 < 0) {
-		if (f2 < 0)
-			return f1 > f2;
-		else if (f2 > 0)
-			return true;
-		return true;
-
+/*
+* Andrew's monotone chain. Sorts the points and walks them once for each of the lower and upper chains,
+* replacing the contents of points with the hull in counter-clockwise order (as seen with y pointing up).
+* Collinear and duplicate points are dropped.
+*/
+void Geometry::calculateConvexHull(std::vector<Point2d>& points) {
+	if (points.size() < 3) {
+		return;
 	}
-
-	return false;
-}
-
-std::vector<float> Geometry::calculateSlopes(const std::vector<Point2d> v_g) {
-
-	uint32_t diff_x, diff_y;
-	std::vector<float> v_f;
-	
-	for (int i = 1; i < v_g.size(); i++) {
-		diff_x = v_g[i].x - v_g[0].x;
-		diff_y = v_g[i].y - v_g[0].y;
-		if (diff_x == 0) {
-			v_f.push_back(1.0f);
-			continue;
+	std::sort(points.begin(), points.end());
+
+	auto cross = [](const Point2d& o, const Point2d& a, const Point2d& b) {
+		return ((int64_t)a.x - o.x) * ((int64_t)b.y - o.y) - ((int64_t)a.y - o.y) * ((int64_t)b.x - o.x);
+	};
+
+	std::vector<Point2d> hull(2 * points.size());
+	size_t k = 0;
+	// Lower chain
+	for (size_t i = 0; i < points.size(); i++) {
+		while (k >= 2 && cross(hull[k - 2], hull[k - 1], points[i]) <= 0) {
+			k--;
 		}
-		v_f.push_back((float)diff_y / diff_x);
+		hull[k++] = points[i];
 	}
-	return v_f;
-}
-
-void Geometry::sortBySlope(std::vector<Point2d>& vertices, const std::vector<float> slopes) {
-
-	// sort by least negative -> most negative -> 1 -> most positive -> least positive to enforce clockwise traversal of vertices
-	for (int i = 0; i < slopes.size() - 1; i++) {
-		// both less than zero
-		if (slopes[i] < 0 && slopes[i + 1] < 0) {
-			if (slopes[i] < slopes[i + 1])
-				std::swap(vertices[i + 1], vertices[i + 2]);
+	// Upper chain, skipping the last point which already closes the lower chain
+	for (size_t i = points.size() - 1, lower = k + 1; i > 0; i--) {
+		while (k >= lower && cross(hull[k - 2], hull[k - 1], points[i - 1]) <= 0) {
+			k--;
 		}
+		hull[k++] = points[i - 1];
 	}
+	// First point is repeated at the end
+	hull.resize(k - 1);
+	points.swap(hull);
 }
 
 Line::Line(const Line& source) {
@@ -139,6 +295,8 @@ Line::Line(const Line& source) {
 	vertices.clear();
 	vertices.push_back(source.vertices[0]);
 	vertices.push_back(source.vertices[1]);
+	edges = source.edges;
+	bounds = source.bounds;
 	initialized = true;
 }
 
@@ -149,6 +307,8 @@ Line::Line(const Geometry& source) {
 	vertices.clear();
 	vertices.push_back(source.vertices[0]);
 	vertices.push_back(source.vertices[1]);
+	edges = source.edges;
+	bounds = source.bounds;
 	initialized = true;
 };
 
@@ -156,46 +316,32 @@ Line::Line(const Point2d& a, const Point2d& b) : Geometry(G_LINE) {
 	vertices.clear();
 	vertices.push_back(a);
 	vertices.push_back(b);
+	// A single equation through both endpoints, used for on-line tests
+	edges.push_back(EdgeEquation(a, b));
+	calculateBounds();
 	initialized = true;
 	return;
 }
 
 bool Line::checkCollisionWith(const Point2d& p) {
-	return calculateClippedY(p.x) == p.y;
+	if (edges.empty()) {
+		return false;
+	}
+	// Within the extent of the segment and no more than half a pixel off it along the major axis
+	const Point2d& a = vertices.at(0);
+	const Point2d& b = vertices.at(1);
+	if (p.x < min(a.x, b.x) || p.x > max(a.x, b.x) || p.y < min(a.y, b.y) || p.y > max(a.y, b.y)) {
+		return false;
+	}
+	const EdgeEquation& e = edges.front();
+	int64_t distance = e.evaluate(p);
+	return 2 * (distance < 0 ? -distance : distance) <= max(e.a < 0 ? -e.a : e.a, e.b < 0 ? -e.b : e.b);
 }
 
-void Line::checkCollisionWith(Geometry* g, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {
-	switch (g->type) {
-	case (Geometry::G_LINE):
-	{
-		Line l = static_cast<Line>(*g);
-		findIntersection(l, collisions, interferingSides);
-	} break;
-	case (Geometry::G_TRI):
-	{
-		Tri t = static_cast<Tri>(*g);
-		Line sides[3] = { Line(t.vertices.at(0), t.vertices.at(1)), Line(t.vertices.at(1), t.vertices.at(2)), Line(t.vertices.at(2), t.vertices.at(0)) };
-		for (Line l : sides) {
-			findIntersection(l, collisions, interferingSides);
-		}
-	} break;
-	case (Geometry::G_RECT):
-	{
-		Rect r = static_cast<Rect>(*g);
-		checkCollisionWith(r, collisions, interferingSides);
-	} break;
-	case (Geometry::G_QUAD):
-	{
-		Quad q = static_cast<Quad>(*g);
-		Line sides[4] = { Line(q.vertices.at(0), q.vertices.at(1)), Line(q.vertices.at(1), q.vertices.at(2)), Line(q.vertices.at(2), q.vertices.at(3)), Line(q.vertices.at(3), q.vertices.at(0)) };
-		for (Line l : sides) {
-			findIntersection(l, collisions, interferingSides);
-		}
-	} break;
-	case (Geometry::G_CIRCLE):
-	{
-
-	} break;
+void Line::containsPoints(const std::vector<Point2d>& points, std::vector<uint8_t>& results) {
+	results.resize(points.size());
+	for (size_t i = 0; i < points.size(); i++) {
+		results[i] = (uint8_t)checkCollisionWith(points[i]);
 	}
 }
 
@@ -314,28 +460,32 @@ bool Line::hasOverlappingRange(Line l) {
 }
 
 void Line::findIntersection(Line l, Point2d& intersection) {
+	intersectSegments(vertices.at(0), vertices.at(1), l.vertices.at(0), l.vertices.at(1), intersection);
+}
+
+void Line::intersectSegments(const Point2d& p0, const Point2d& p1, const Point2d& q0, const Point2d& q1, Point2d& intersection) {
 	
 	// Line AB represented as a1x + b1y = c1
-	double a1 = static_cast<double>(l.vertices.at(1).y) - l.vertices.at(0).y; // cast to double to prevent unsigned calculation from rolling over
-	double b1 = static_cast<double>(l.vertices.at(0).x) - l.vertices.at(1).x;
-	double c1 = a1 * (l.vertices.at(0).x) + b1 * (l.vertices.at(0).y);
+	double a1 = static_cast<double>(q1.y) - q0.y; // cast to double to prevent unsigned calculation from rolling over
+	double b1 = static_cast<double>(q0.x) - q1.x;
+	double c1 = a1 * (q0.x) + b1 * (q0.y);
 
 	// Line CD represented as a2x + b2y = c2
-	double a2 = static_cast<double>(vertices.at(1).y) - vertices.at(0).y;
-	double b2 = static_cast<double>(vertices.at(0).x) - vertices.at(1).x;
-	double c2 = a2 * (vertices.at(0).x) + b2 * (vertices.at(0).y);
+	double a2 = static_cast<double>(p1.y) - p0.y;
+	double b2 = static_cast<double>(p0.x) - p1.x;
+	double c2 = a2 * (p0.x) + b2 * (p0.y);
 
 	double determinant = a1 * b2 - a2 * b1;
 
 	if (determinant != 0) {
-		uint32_t minX = min(vertices.at(0).x, vertices.at(1).x);
-		uint32_t maxX = max(vertices.at(0).x, vertices.at(1).x);
-		uint32_t minY = min(vertices.at(0).y, vertices.at(1).y);
-		uint32_t maxY = max(vertices.at(0).y, vertices.at(1).y);
-		uint32_t minLX = min(l.vertices.at(0).x, l.vertices.at(1).x);
-		uint32_t maxLX = max(l.vertices.at(0).x, l.vertices.at(1).x);
-		uint32_t minLY = min(l.vertices.at(0).y, l.vertices.at(1).y);
-		uint32_t maxLY = max(l.vertices.at(0).y, l.vertices.at(1).y);
+		uint32_t minX = min(p0.x, p1.x);
+		uint32_t maxX = max(p0.x, p1.x);
+		uint32_t minY = min(p0.y, p1.y);
+		uint32_t maxY = max(p0.y, p1.y);
+		uint32_t minLX = min(q0.x, q1.x);
+		uint32_t maxLX = max(q0.x, q1.x);
+		uint32_t minLY = min(q0.y, q1.y);
+		uint32_t maxLY = max(q0.y, q1.y);
 
 		uint32_t x = static_cast<uint32_t>((b2 * c1 - b1 * c2) / determinant + 0.5);
 		uint32_t y = static_cast<uint32_t>((a1 * c2 - a2 * c1) / determinant + 0.5);
@@ -353,6 +503,8 @@ Tri::Tri(const Tri& source) : Geometry(G_TRI) {
 	for (int i = 0; i < source.vertices.size(); i++) {
 		vertices.push_back(source.vertices[i]);
 	}
+	edges = source.edges;
+	bounds = source.bounds;
 }
 
 Tri::Tri(const Geometry& source) {
@@ -364,6 +516,8 @@ Tri::Tri(const Geometry& source) {
 	for (int i = 0; i < source.vertices.size(); i++) {
 		vertices.push_back(source.vertices[i]);
 	}
+	edges = source.edges;
+	bounds = source.bounds;
 };
 
 Tri::Tri(const Point2d& a, const Point2d& b, const Point2d& c) : Geometry(G_TRI) {
@@ -376,32 +530,10 @@ Tri::Tri(const Point2d& a, const Point2d& b, const Point2d& c) : Geometry(G_TRI)
 	index = comparePointsByCoordinate(CompareType::COMPARE_BY_X, &vertices, nullptr, nullptr, 1);
 	if (index != 1)
 		std::swap(vertices.at(1), vertices.at(index));
+	calculateEdgeEquations();
+	calculateBounds();
 };
 
-void Tri::checkCollisionWith(Geometry* g, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {
-	switch (g->type) {
-	case (Geometry::G_LINE):
-	{
-	} break;
-	case (Geometry::G_TRI):
-	{
-
-	} break;
-	case (Geometry::G_RECT):
-	{
-
-	} break;
-	case (Geometry::G_QUAD):
-	{
-
-	} break;
-	case (Geometry::G_CIRCLE):
-	{
-
-	} break;
-	}
-}
-
 Rect::Rect(const Rect& source) {
 	if (source.vertices.size() != 4)
 		return;
@@ -415,6 +547,8 @@ Rect::Rect(const Rect& source) {
 	rb = source.rb;
 	lb = source.lb;
 	rt = source.rt;
+	edges = source.edges;
+	bounds = source.bounds;
 }
 
 Rect::Rect(const Geometry& source) {
@@ -430,6 +564,8 @@ Rect::Rect(const Geometry& source) {
 	lt = vertices.at(1);
 	rt = vertices.at(2);
 	rb = vertices.at(3);
+	edges = source.edges;
+	bounds = source.bounds;
 };
 
 Rect::Rect(const Point2d& a, const Point2d& b) : Geometry(G_RECT) {
@@ -442,6 +578,8 @@ Rect::Rect(const Point2d& a, const Point2d& b) : Geometry(G_RECT) {
 	vertices.push_back(lt);
 	vertices.push_back(rt);
 	vertices.push_back(rb);
+	calculateEdgeEquations();
+	calculateBounds();
 };
 
 Rect::Rect(const RECT& rect) : Geometry(G_RECT) {
@@ -454,47 +592,11 @@ Rect::Rect(const RECT& rect) : Geometry(G_RECT) {
 	vertices.push_back(lt);
 	vertices.push_back(rt);
 	vertices.push_back(rb);
+	calculateEdgeEquations();
+	calculateBounds();
 };
 
 
-void Rect::checkCollisionWith(Geometry* g, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {
-	switch (g->type) {
-	case (Geometry::G_LINE):
-	{
-		Line l = static_cast<Line>(*g);
-		// Needs to account for collisions with all sides of rect
-		uint32_t leftSideY = l.calculateClippedY(lt.x);
-		uint32_t rightSideY = l.calculateClippedY(rt.x);
-		bool lineCrossesSides = leftSideY || rightSideY;
-
-		if (leftSideY) {
-			Point2d p = Point2d(lt.x, leftSideY);
-			collisions.push_back(p);
-		}
-		if (rightSideY) {
-			Point2d p = Point2d(rt.x, rightSideY);
-			collisions.push_back(p);
-		}
-	} break;
-	case (Geometry::G_TRI):
-	{
-
-	} break;
-	case (Geometry::G_RECT):
-	{
-
-	} break;
-	case (Geometry::G_QUAD):
-	{
-
-	} break;
-	case (Geometry::G_CIRCLE):
-	{
-
-	} break;
-	}
-}
-
 Quad::Quad(const Quad& source) {
 	if (source.type != G_QUAD || source.vertices.size() != 4)
 		return;
@@ -504,6 +606,9 @@ Quad::Quad(const Quad& source) {
 	for (int i = 0; i < source.vertices.size(); i++) {
 		vertices.push_back(source.vertices[i]);
 	}
+	edges = source.edges;
+	bounds = source.bounds;
+	convex = source.convex;
 };
 
 Quad::Quad(const Geometry& source) {
@@ -515,29 +620,142 @@ Quad::Quad(const Geometry& source) {
 	for (int i = 0; i < source.vertices.size(); i++) {
 		vertices.push_back(source.vertices[i]);
 	}
+	edges = source.edges;
+	bounds = source.bounds;
+	convex = calculateConvexity();
 }
-void Quad::checkCollisionWith(Geometry* g, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {
-	switch (g->type) {
-	case (Geometry::G_LINE):
-	{
-	} break;
-	case (Geometry::G_TRI):
-	{
 
-	} break;
-	case (Geometry::G_RECT):
-	{
+Quad::Quad(const Point2d& a, const Point2d& b, const Point2d& c, const Point2d& d) : Geometry(G_QUAD) {
+	auto orientation = [](const Point2d& o, const Point2d& p, const Point2d& q) {
+		int64_t cross = ((int64_t)p.x - o.x) * ((int64_t)q.y - o.y) - ((int64_t)p.y - o.y) * ((int64_t)q.x - o.x);
+		return (cross > 0) - (cross < 0);
+	};
+	// Sides p0p1 and q0q1 cross at a point inside both
+	auto crosses = [&](const Point2d& p0, const Point2d& p1, const Point2d& q0, const Point2d& q1) {
+		return orientation(p0, p1, q0) * orientation(p0, p1, q1) < 0 && orientation(q0, q1, p0) * orientation(q0, q1, p1) < 0;
+	};
+	// Of the three ways round four points, at least one has no crossing sides. Only opposite sides can cross
+	const Point2d orders[3][4] = { { a, b, c, d }, { a, b, d, c }, { a, c, b, d } };
+	int chosen = 0;
+	for (int i = 0; i < 3; i++) {
+		const Point2d* o = orders[i];
+		if (!crosses(o[0], o[1], o[2], o[3]) && !crosses(o[1], o[2], o[3], o[0])) {
+			chosen = i;
+			break;
+		}
+	}
+	vertices.assign(orders[chosen], orders[chosen] + 4);
+	convex = calculateConvexity();
+	calculateEdgeEquations();
+	calculateBounds();
+}
 
-	} break;
-	case (Geometry::G_QUAD):
-	{
+void Quad::containsPoints(const std::vector<Point2d>& points, std::vector<uint8_t>& results) {
+	if (convex) {
+		Geometry::containsPoints(points, results);
+		return;
+	}
+	results.resize(points.size());
+	for (size_t i = 0; i < points.size(); i++) {
+		results[i] = (uint8_t)checkCrossingNumber(points[i]);
+	}
+}
+Poly::Poly(const Poly& source) : Geometry(G_POLYGON) {
+	vertices = source.vertices;
+	edges = source.edges;
+	bounds = source.bounds;
+	convex = source.convex;
+}
 
-	} break;
-	case (Geometry::G_CIRCLE):
-	{
+Poly::Poly(const Geometry& source) {
+	if (source.type != G_POLYGON || source.vertices.size() < 3)
+		return;
 
-	} break;
+	type = source.type;
+	vertices = source.vertices;
+	edges = source.edges;
+	bounds = source.bounds;
+	convex = calculateConvexity();
+}
+
+Poly::Poly(const std::vector<Point2d>& points, bool hull) : Geometry(G_POLYGON) {
+	vertices.reserve(points.size());
+	if (hull) {
+		vertices = points;
+		calculateConvexHull(vertices);
+	} else {
+		// Keep the caller's ordering, dropping repeated consecutive vertices
+		for (const Point2d& p : points) {
+			if (vertices.empty() || vertices.back() != p) {
+				vertices.push_back(p);
+			}
+		}
+		if (vertices.size() > 1 && vertices.front() == vertices.back()) {
+			vertices.pop_back();
+		}
 	}
+	convex = hull || calculateConvexity();
+	calculateEdgeEquations();
+	calculateBounds();
+}
+
+bool Poly::checkCollisionWith(const Point2d& p) {
+	if (convex) {
+		return checkEdgeEquations(p);
+	}
+	return checkCrossingNumber(p);
+}
+
+void Poly::containsPoints(const std::vector<Point2d>& points, std::vector<uint8_t>& results) {
+	if (convex) {
+		Geometry::containsPoints(points, results);
+		return;
+	}
+	results.resize(points.size());
+	for (size_t i = 0; i < points.size(); i++) {
+		results[i] = (uint8_t)checkCrossingNumber(points[i]);
+	}
+}
+
+bool Geometry::checkCrossingNumber(const Point2d& p) const {
+	// Even-odd rule, counting crossings of a ray cast in positive x. Division free so it stays in integers
+	bool inside = false;
+	for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++) {
+		const Point2d& vi = vertices[i];
+		const Point2d& vj = vertices[j];
+		if ((vi.y > p.y) == (vj.y > p.y)) {
+			continue;
+		}
+		int64_t dy = (int64_t)vj.y - vi.y;
+		int64_t lhs = ((int64_t)p.x - vi.x) * dy;
+		int64_t rhs = ((int64_t)vj.x - vi.x) * ((int64_t)p.y - vi.y);
+		if (dy > 0 ? lhs < rhs : lhs > rhs) {
+			inside = !inside;
+		}
+	}
+	return inside;
+}
+
+bool Geometry::calculateConvexity() const {
+	if (vertices.size() < 3) {
+		return false;
+	}
+	int sign = 0;
+	for (size_t i = 0; i < vertices.size(); i++) {
+		const Point2d& o = vertices[i];
+		const Point2d& a = vertices[(i + 1) % vertices.size()];
+		const Point2d& b = vertices[(i + 2) % vertices.size()];
+		int64_t cross = ((int64_t)a.x - o.x) * ((int64_t)b.y - o.y) - ((int64_t)a.y - o.y) * ((int64_t)b.x - o.x);
+		if (cross == 0) {
+			continue;
+		}
+		if (sign == 0) {
+			sign = cross > 0 ? 1 : -1;
+		} else if ((cross > 0 ? 1 : -1) != sign) {
+			return false;
+		}
+	}
+	return true;
 }
 
 Circle::Circle(const Point2d& p_c, uint16_t p_r) : Geometry(G_CIRCLE) {
@@ -545,6 +763,7 @@ Circle::Circle(const Point2d& p_c, uint16_t p_r) : Geometry(G_CIRCLE) {
 	r = p_r;
 	vertices.push_back(center);
 	createVertexShell();
+	calculateBounds();
 }
 
 Circle::Circle(const Point2d& p_c, const Point2d& p_r) : Geometry(G_CIRCLE) {
@@ -552,19 +771,20 @@ Circle::Circle(const Point2d& p_c, const Point2d& p_r) : Geometry(G_CIRCLE) {
 	r = static_cast<uint16_t>(sqrt(((p_c.x - p_r.x) * (p_c.x - p_r.x)) + ((p_c.y - p_r.y) * (p_c.y - p_r.y))));
 	vertices.push_back(center);
 	createVertexShell();
+	calculateBounds();
 }
 
 Circle::Circle(const Circle& source) : Geometry(G_CIRCLE) {
 	center = source.center;
 	r = source.r;
-	vertices.push_back(center);
 	for (Point2d v : source.vertices) {
 		vertices.push_back(v);
 	}
+	bounds = source.bounds;
 }
 
 Circle::Circle(const Geometry& source) {
-	if (source.type != G_CIRCLE && source.vertices.size() != Circle::SIDE_COUNT + 1) {
+	if (source.type != G_CIRCLE || source.vertices.size() != Circle::SIDE_COUNT + 1) {
 		return;
 	}
 	
@@ -573,37 +793,103 @@ Circle::Circle(const Geometry& source) {
 		vertices.push_back(v);
 	}
 	center = source.vertices.at(0);
+	// First shell vertex sits at 0 degrees, directly right of center
+	r = static_cast<uint16_t>(source.vertices.at(1).x - center.x);
+	bounds = source.bounds;
 }
 
-void Circle::checkCollisionWith(Geometry* g, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) {
-	switch (g->type) {
-	case (Geometry::G_LINE):
-	{
-	} break;
-	case (Geometry::G_TRI):
-	{
+void Circle::containsPoints(const std::vector<Point2d>& points, std::vector<uint8_t>& results) {
+	results.resize(points.size());
+	int64_t rSquared = (int64_t)r * r;
+	for (size_t i = 0; i < points.size(); i++) {
+		results[i] = (uint8_t)(center.squaredDisplacementFrom(points[i]) <= rSquared);
+	}
+}
 
-	} break;
-	case (Geometry::G_RECT):
-	{
+bool Circle::intersectsSegment(const Point2d& a, const Point2d& b) const {
+	// Project the center onto ab and compare the squared distance against r^2, without taking any roots
+	double dx = static_cast<double>(b.x) - a.x;
+	double dy = static_cast<double>(b.y) - a.y;
+	double px = static_cast<double>(center.x) - a.x;
+	double py = static_cast<double>(center.y) - a.y;
+	double rSquared = static_cast<double>(r) * r;
+	double lengthSquared = dx * dx + dy * dy;
+	double dotProduct = px * dx + py * dy;
+
+	// Closest point is a
+	if (dotProduct <= 0 || lengthSquared == 0) {
+		return px * px + py * py <= rSquared;
+	}
+	// Closest point is b
+	if (dotProduct >= lengthSquared) {
+		return center.squaredDisplacementFrom(b) <= (int64_t)r * r;
+	}
+	// Closest point is interior, squared perpendicular distance = cross^2 / |ab|^2
+	double crossProduct = px * dy - py * dx;
+	return crossProduct * crossProduct <= rSquared * lengthSquared;
+}
 
-	} break;
-	case (Geometry::G_QUAD):
-	{
+bool Circle::intersectsCircle(const Circle& c) const {
+	int64_t reach = (int64_t)r + c.r;
+	return center.squaredDisplacementFrom(c.center) <= reach * reach;
+}
 
-	} break;
-	case (Geometry::G_CIRCLE):
-	{
+bool Circle::intersectsRect(const Rect& rect) const {
+	// Clamp the center into the rect to find the closest point
+	Point2d closest = Point2d(min(max(center.x, rect.lt.x), rect.rb.x), min(max(center.y, rect.lt.y), rect.rb.y));
+	return center.squaredDisplacementFrom(closest) <= (int64_t)r * r;
+}
 
-	} break;
+void Circle::findIntersections(const Point2d& a, const Point2d& b, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) const {
+	// Solve |a + t(b - a) - center|^2 = r^2 for t in [0, 1]
+	double dx = static_cast<double>(b.x) - a.x;
+	double dy = static_cast<double>(b.y) - a.y;
+	double fx = static_cast<double>(a.x) - center.x;
+	double fy = static_cast<double>(a.y) - center.y;
+	double A = dx * dx + dy * dy;
+	double B = 2 * (fx * dx + fy * dy);
+	double C = fx * fx + fy * fy - static_cast<double>(r) * r;
+	double discriminant = B * B - 4 * A * C;
+	if (A == 0 || discriminant < 0) {
+		return;
+	}
+
+	double root = sqrt(discriminant);
+	double t[2] = { (-B - root) / (2 * A), (-B + root) / (2 * A) };
+	int count = discriminant == 0 ? 1 : 2;
+	for (int i = 0; i < count; i++) {
+		if (t[i] < 0 || t[i] > 1) {
+			continue;
+		}
+		Point2d p = Point2d(static_cast<uint32_t>(a.x + t[i] * dx + 0.5), static_cast<uint32_t>(a.y + t[i] * dy + 0.5));
+		collisions.push_back(p);
+		interferingSides.push_back(calculateTangent(p));
 	}
 }
 
+Point2d Circle::findClosestPointOnCircle(const Point2d& p) const {
+	double dx = static_cast<double>(p.x) - center.x;
+	double dy = static_cast<double>(p.y) - center.y;
+	double length = sqrt(dx * dx + dy * dy);
+	if (length == 0) {
+		return Point2d(center.x + r, center.y);
+	}
+	return Point2d(static_cast<uint32_t>(center.x + r * dx / length + 0.5), static_cast<uint32_t>(center.y + r * dy / length + 0.5));
+}
+
+Line Circle::calculateTangent(const Point2d& p) const {
+	// Tangent is perpendicular to the radius through p, spanning one radius in each direction
+	int64_t rx = (int64_t)p.x - center.x;
+	int64_t ry = (int64_t)p.y - center.y;
+	Point2d a = Point2d((uint32_t)max((int64_t)0, (int64_t)p.x + ry), (uint32_t)max((int64_t)0, (int64_t)p.y - rx));
+	Point2d b = Point2d((uint32_t)max((int64_t)0, (int64_t)p.x - ry), (uint32_t)max((int64_t)0, (int64_t)p.y + rx));
+	return Line(a, b);
+}
+
 void Circle::createVertexShell() {
-	double increment = 360 / Circle::SIDE_COUNT;
 	for (int i = 0; i < Circle::SIDE_COUNT; i++) {
-		double cosx = cos(i * increment * M_PI / 180);
-		double siny = sin(i * increment * M_PI / 180);
+		double cosx, siny;
+		BinaryAngle((uint16_t)(i * BinaryAngle::UNITS_PER_TURN / Circle::SIDE_COUNT)).sincos(siny, cosx);
 		Point2d v = Point2d(center.x + static_cast<int32_t>(r * cosx), center.y + static_cast<int32_t>(r * siny));
 		vertices.push_back(v);
 	}
@@ -612,8 +898,7 @@ void Circle::createVertexShell() {
 
 Camera::Camera(uint32_t p_x, uint32_t p_y, float p_direction) {
 	x = p_x; y = p_y;
-	direction = p_direction;
-	clampDirection();
+	direction = BinaryAngle::fromDegrees(p_direction);
 	size = 10;
 	px = (float)p_x; py = (float)p_y;
 	vx = 0.0f; vy = 0.0f;
@@ -622,35 +907,41 @@ Camera::Camera(uint32_t p_x, uint32_t p_y, float p_direction) {
 	update();
 }
 
+Wedge Camera::getViewWedge(uint32_t reach) const {
+	BinaryAngle half = BinaryAngle((uint16_t)(BinaryAngle::fromDegrees(fov).value / 2));
+	return Wedge(*this, direction - half, direction + half, reach);
+}
+
 void Camera::update() {
-	// Direction = 0 - 360, clockwise from positive x axis
-	double cosx = cos(direction * M_PI / 180);
-	double siny = sin(direction * M_PI / 180);
+	// Direction is a binary angle, clockwise from positive x axis. All sin/cos values come from the lookup table
+	double cosx, siny;
+	direction.sincos(siny, cosx);
 	base = Point2d((uint32_t)(x - size * cosx / 2 + 0.5), (uint32_t)(y - size * siny / 2 + 0.5));
 	tip = Point2d((uint32_t)(x + size * cosx / 2 + 0.5), (uint32_t)(y + size * siny / 2 + 0.5));
-	double arrowPointLength = (size / 2) * sin((fov / 2) * M_PI / 180);
+	double arrowPointLength = (size / 2) * BinaryAngle::fromDegrees(fov / 2).sin();
 
-	left = Point2d((uint32_t)(tip.x + (-arrowPointLength * cos((direction + (90 - fov / 2)) * M_PI / 180)) + 0.5), (uint32_t)(tip.y + (-arrowPointLength * sin((direction + (90 - fov / 2)) * M_PI / 180)) + 0.5));
-	right = Point2d((uint32_t)(tip.x + (-arrowPointLength * cos((direction - (90 - fov / 2)) * M_PI / 180)) + 0.5), (uint32_t)(tip.y + (-arrowPointLength * sin((direction - (90 - fov / 2)) * M_PI / 180)) + 0.5));
+	BinaryAngle arrowOffset = BinaryAngle::fromDegrees(90 - fov / 2);
+	double cosl, sinl, cosr, sinr;
+	(direction + arrowOffset).sincos(sinl, cosl);
+	(direction - arrowOffset).sincos(sinr, cosr);
+	left = Point2d((uint32_t)(tip.x + (-arrowPointLength * cosl) + 0.5), (uint32_t)(tip.y + (-arrowPointLength * sinl) + 0.5));
+	right = Point2d((uint32_t)(tip.x + (-arrowPointLength * cosr) + 0.5), (uint32_t)(tip.y + (-arrowPointLength * sinr) + 0.5));
 
 	// Maintain bounding box for collisions
-	boundingBox[0] = Point2d(static_cast<uint32_t>(x + c2C * cos((direction - (90 + theta)) * M_PI / 180) + 0.5), static_cast<uint32_t>(y + c2C * sin((direction - (90 + theta)) * M_PI / 180) + 0.5));
-	boundingBox[1] = Point2d(static_cast<uint32_t>(x + c2C * cos((direction - (90 - theta)) * M_PI / 180) + 0.5), static_cast<uint32_t>(y + c2C * sin((direction - (90 - theta)) * M_PI / 180) + 0.5));
-	boundingBox[2] = Point2d(static_cast<uint32_t>(x + c2C * cos((direction + (90 - theta)) * M_PI / 180) + 0.5), static_cast<uint32_t>(y + c2C * sin((direction + (90 - theta)) * M_PI / 180) + 0.5));
-	boundingBox[3] = Point2d(static_cast<uint32_t>(x + c2C * cos((direction + (90 + theta)) * M_PI / 180) + 0.5), static_cast<uint32_t>(y + c2C * sin((direction + (90 + theta)) * M_PI / 180) + 0.5));
+	BinaryAngle corners[4] = { direction - BinaryAngle::fromDegrees(90 + theta), direction - BinaryAngle::fromDegrees(90 - theta), direction + BinaryAngle::fromDegrees(90 - theta), direction + BinaryAngle::fromDegrees(90 + theta) };
+	for (int i = 0; i < 4; i++) {
+		double cosc, sinc;
+		corners[i].sincos(sinc, cosc);
+		boundingBox[i] = Point2d(static_cast<uint32_t>(x + c2C * cosc + 0.5), static_cast<uint32_t>(y + c2C * sinc + 0.5));
+	}
 	leftSide = Line(boundingBox[0], boundingBox[1]);
 	front = Line(boundingBox[1], boundingBox[2]);
 	rightSide = Line(boundingBox[2], boundingBox[3]);
 	back = Line(boundingBox[3], boundingBox[0]);
 
-}
+	uint32_t reach = size / 2;
+	bounds = BoundingBox(x > reach ? x - reach : 0, y > reach ? y - reach : 0, x + reach, y + reach);
 
-void Camera::clampDirection() {
-	if (direction < 0) {
-		direction = 360.0f - (-direction - (int)(direction / -360) * 360);
-		return;
-	}
-	direction -= (int)(direction / 360) * 360.0f;
 }
 
 void Camera::clampPosition(Rect panel) {
@@ -689,16 +980,15 @@ void Camera::clampPosition(const Line& l, const Point2d collision) {
 void Camera::clampVelocity() {
 	double totalVelocity = sqrt(vx * vx + vy * vy);
 	if (totalVelocity > velocityLimit) {
-		double angle = direction * M_PI / 180;
-		vx = velocityLimit * cos(angle);
-		vy = velocityLimit * sin(angle);
+		vx = velocityLimit * direction.cos();
+		vy = velocityLimit * direction.sin();
 	} // current buggy when moving backwards
 }
 void Camera::clampAcceleration() {
 	double totalAcceleration = sqrt(ax * ax + ay * ay);
 	if (totalAcceleration > accelerationLimit) {
-		ax = accelerationLimit * cos(direction * M_PI / 180);
-		ay = accelerationLimit * sin(direction * M_PI / 180);
+		ax = accelerationLimit * direction.cos();
+		ay = accelerationLimit * direction.sin();
 	}
 }
 
@@ -712,63 +1002,271 @@ void Camera::clampAngularAcceleration() {
 	}
 }
 
-void Camera::checkCollisionWith(Geometry* g, std::map<Point2d, std::vector<Line>>& collisions) {
+void Camera::checkCollisionWith(Geometry* g, ContactManifold& manifold) {
+	if (!BroadPhase::test(bounds, g->bounds)) {
+		return;
+	}
 	switch (g->type) {
 	case (Geometry::G_LINE):
 	{
-		Line l = static_cast<Line>(*g);
-		findIntersection(l, collisions);
+		findIntersection(g->vertices.at(0), g->vertices.at(1), g, 0, manifold);
 	} break;
 	case (Geometry::G_TRI):
+	case (Geometry::G_RECT):
+	case (Geometry::G_QUAD):
+	case (Geometry::G_POLYGON):
 	{
-		Tri t = static_cast<Tri>(*g);
-		Line sides[3] = { Line(t.vertices.at(0), t.vertices.at(1)), Line(t.vertices.at(1), t.vertices.at(2)), Line(t.vertices.at(2), t.vertices.at(0)) };
-		for (Line l : sides) {
-			findIntersection(l, collisions);
+		// Vertices are stored in order around each shape, so side i runs from vertex i to vertex i + 1
+		for (int i = 0; i < g->vertices.size(); i++) {
+			findIntersection(g->vertices.at(i), g->vertices.at(i + 1 == g->vertices.size() ? 0 : i + 1), g, i, manifold);
 		}
 	} break;
-	case (Geometry::G_RECT):
+	case (Geometry::G_CIRCLE):
 	{
-		Rect r = static_cast<Rect>(*g);
-		Line sides[4] = { Line(r.lb, r.lt), Line(r.lt, r.rt), Line(r.rt, r.rb), Line(r.rb, r.lb) };
-		for (Line l : sides) {
-			findIntersection(l, collisions);
+		// One squared distance test against the true circle instead of intersecting each side of the vertex shell
+		Circle* c = static_cast<Circle*>(g);
+		double reach = (double)c->r + size / 2;
+		double dx = px - c->center.x;
+		double dy = py - c->center.y;
+		double distanceSquared = dx * dx + dy * dy;
+		if (distanceSquared == 0 || distanceSquared > reach * reach) {
+			break;
 		}
+		double distance = sqrt(distanceSquared);
+		Contact contact;
+		contact.nx = dx / distance;
+		contact.ny = dy / distance;
+		contact.point = Point2d((uint32_t)(c->center.x + c->r * contact.nx + 0.5), (uint32_t)(c->center.y + c->r * contact.ny + 0.5));
+		contact.depth = reach - distance;
+		contact.geometry = g;
+		contact.edge = -1;
+		manifold.add(contact);
 	} break;
+	}
+}
+
+void Camera::findIntersection(const Point2d& a, const Point2d& b, Geometry* g, int16_t edge, ContactManifold& manifold) {
+	// Closest point on ab to the camera center, compared on squared distance before any root is taken
+	double dx = (double)b.x - a.x;
+	double dy = (double)b.y - a.y;
+	double lengthSquared = dx * dx + dy * dy;
+	double t = lengthSquared == 0 ? 0 : ((px - a.x) * dx + (py - a.y) * dy) / lengthSquared;
+	t = t < 0 ? 0 : (t > 1 ? 1 : t);
+	double cx = a.x + t * dx;
+	double cy = a.y + t * dy;
+	double reach = size / 2;
+	double distanceSquared = (px - cx) * (px - cx) + (py - cy) * (py - cy);
+	if (distanceSquared > reach * reach || lengthSquared == 0) {
+		return;
+	}
+
+	Contact contact;
+	double distance = sqrt(distanceSquared);
+	if (distance > 0) {
+		contact.nx = (px - cx) / distance;
+		contact.ny = (py - cy) / distance;
+	} else {
+		// Center sits on the side itself, fall back to the side's own normal
+		double length = sqrt(lengthSquared);
+		contact.nx = -dy / length;
+		contact.ny = dx / length;
+	}
+	contact.point = Point2d((uint32_t)(cx + 0.5), (uint32_t)(cy + 0.5));
+	contact.depth = reach - distance;
+	contact.geometry = g;
+	contact.edge = edge;
+	manifold.add(contact);
+}
+
+bool Camera::sweep(Geometry* g, double dx, double dy, double& toi, Contact& contact) const {
+	// Bounds swept over the whole motion, so the broad phase still rejects shapes the camera cannot reach this frame
+	double reach = size / 2;
+	double endX = px + dx, endY = py + dy;
+	double left = min(px, endX) - reach, bottom = min(py, endY) - reach;
+	BoundingBox swept((uint32_t)(left > 0 ? left : 0), (uint32_t)(bottom > 0 ? bottom : 0), (uint32_t)(max(px, endX) + reach + 1), (uint32_t)(max(py, endY) + reach + 1));
+	if (!BroadPhase::test(swept, g->bounds)) {
+		return false;
+	}
+
+	bool hit = false;
+	switch (g->type) {
+	case (Geometry::G_LINE):
+	{
+		if (sweepSegment(g->vertices.at(0), g->vertices.at(1), dx, dy, toi, contact)) {
+			contact.edge = 0;
+			hit = true;
+		}
+	} break;
+	case (Geometry::G_TRI):
+	case (Geometry::G_RECT):
 	case (Geometry::G_QUAD):
+	case (Geometry::G_POLYGON):
 	{
-		Quad q = static_cast<Quad>(*g);
-		Line sides[4] = { Line(q.vertices.at(0), q.vertices.at(1)), Line(q.vertices.at(1), q.vertices.at(2)), Line(q.vertices.at(2), q.vertices.at(3)), Line(q.vertices.at(3), q.vertices.at(0)) };
-		for (Line l : sides) {
-			findIntersection(l, collisions);
+		for (int i = 0; i < g->vertices.size(); i++) {
+			if (sweepSegment(g->vertices.at(i), g->vertices.at(i + 1 == g->vertices.size() ? 0 : i + 1), dx, dy, toi, contact)) {
+				contact.edge = i;
+				hit = true;
+			}
 		}
 	} break;
 	case (Geometry::G_CIRCLE):
 	{
-		Circle c = static_cast<Circle>(*g);
+		const Circle* c = static_cast<const Circle*>(g);
+		if (sweepPoint(c->center.x, c->center.y, (double)c->r + reach, dx, dy, toi, contact)) {
+			contact.point = Point2d((uint32_t)(c->center.x + c->r * contact.nx + 0.5), (uint32_t)(c->center.y + c->r * contact.ny + 0.5));
+			contact.edge = -1;
+			hit = true;
+		}
+	} break;
+	}
+	if (hit) {
+		contact.geometry = g;
+		contact.depth = 0;
+	}
+	return hit;
+}
+
+bool Camera::sweepSegment(const Point2d& a, const Point2d& b, double dx, double dy, double& toi, Contact& contact) const {
+	double ex = (double)b.x - a.x;
+	double ey = (double)b.y - a.y;
+	double lengthSquared = ex * ex + ey * ey;
+	if (lengthSquared == 0) {
+		return sweepPoint(a.x, a.y, size / 2, dx, dy, toi, contact);
+	}
+	double reach = size / 2;
+	bool hit = false;
+
+	// Face of the side: the center reaches the line offset by the radius, on the side the camera starts from
+	double length = sqrt(lengthSquared);
+	double nx = -ey / length, ny = ex / length;
+	double distance = (px - a.x) * nx + (py - a.y) * ny;
+	if (distance < 0) {
+		nx = -nx;
+		ny = -ny;
+		distance = -distance;
+	}
+	double approach = dx * nx + dy * ny;
+	if (approach < 0) {
+		double t = distance > reach ? (distance - reach) / -approach : 0;
+		if (t < toi) {
+			double cx = px + t * dx - nx * reach;
+			double cy = py + t * dy - ny * reach;
+			double s = ((cx - a.x) * ex + (cy - a.y) * ey) / lengthSquared;
+			if (s >= 0 && s <= 1) {
+				toi = t;
+				contact.nx = nx;
+				contact.ny = ny;
+				contact.point = Point2d((uint32_t)(cx + 0.5), (uint32_t)(cy + 0.5));
+				hit = true;
+			}
+		}
+	}
+
+	// End points of the side, where the face test misses the rounded corner of the swept circle
+	if (sweepPoint(a.x, a.y, reach, dx, dy, toi, contact)) {
+		contact.point = a;
+		hit = true;
+	}
+	if (sweepPoint(b.x, b.y, reach, dx, dy, toi, contact)) {
+		contact.point = b;
+		hit = true;
+	}
+	return hit;
+}
 
-		Line sides[Circle::SIDE_COUNT];
-		for (int i = 1; i < Circle::SIDE_COUNT; i++) {
-			sides[i] = Line(c.vertices.at(i), c.vertices.at(i + 1 == Circle::SIDE_COUNT ? 1 : i + 1));
+bool Camera::sweepPoint(double ex, double ey, double radius, double dx, double dy, double& toi, Contact& contact) const {
+	// Solve |p + t*d - e|^2 = radius^2 for the first root t in [0, toi)
+	double ox = px - ex, oy = py - ey;
+	double a = dx * dx + dy * dy;
+	double b = 2 * (ox * dx + oy * dy);
+	double c = ox * ox + oy * oy - radius * radius;
+	if (a == 0 || b >= 0) {
+		// Stationary, or moving away from the point
+		return false;
+	}
+	double t = 0;
+	if (c > 0) {
+		double discriminant = b * b - 4 * a * c;
+		if (discriminant < 0) {
+			return false;
 		}
-		for (Line l : sides) {
-			findIntersection(l, collisions);
+		t = (-b - sqrt(discriminant)) / (2 * a);
+	}
+	if (t >= toi) {
+		return false;
+	}
+	double cx = ox + t * dx, cy = oy + t * dy;
+	double distance = sqrt(cx * cx + cy * cy);
+	if (distance == 0) {
+		return false;
+	}
+	toi = t;
+	contact.nx = cx / distance;
+	contact.ny = cy / distance;
+	contact.point = Point2d((uint32_t)(ex + 0.5), (uint32_t)(ey + 0.5));
+	return true;
+}
+
+void Contact::calculateTangent(double& tx, double& ty) const {
+	if (edge < 0 || !geometry) {
+		tx = -ny;
+		ty = nx;
+		return;
+	}
+	const Point2d& a = geometry->vertices.at(edge);
+	const Point2d& b = geometry->vertices.at(edge + 1 == geometry->vertices.size() ? 0 : edge + 1);
+	double dx = (double)b.x - a.x;
+	double dy = (double)b.y - a.y;
+	double length = sqrt(dx * dx + dy * dy);
+	tx = length > 0 ? dx / length : 0;
+	ty = length > 0 ? dy / length : 0;
+}
+
+bool ContactManifold::add(const Contact& c) {
+	// Keep the deepest contacts once full, since those drive the response
+	if (count < CAPACITY) {
+		contacts[count++] = c;
+		return true;
+	}
+	int shallowest = 0;
+	for (int i = 1; i < CAPACITY; i++) {
+		if (contacts[i].depth < contacts[shallowest].depth) {
+			shallowest = i;
 		}
-	} break;
 	}
+	if (contacts[shallowest].depth >= c.depth) {
+		return false;
+	}
+	contacts[shallowest] = c;
+	return true;
 }
 
-void Camera::findIntersection(Line& l, std::map<Point2d, std::vector<Line>>& collisions) {
-	Point2d center = Point2d(x, y);
-	Point2d p = l.findClosestPointOnLine(center);
-	if (p.displacementFrom(center) <= (size / 2)) {
-		auto it = collisions.find(p);
-
-		if (it != collisions.end()) {
-			it->second.push_back(l);
-		} else {
-			std::vector<Line> interferingSides = { l };
-			collisions.insert({ p, interferingSides });
+bool ContactManifold::resolveDisplacement(double& dx, double& dy, int iterations) const {
+	// Removing the normal component leaves the motion along the contact tangent, using only dot products.
+	// One pass can push the motion back into an earlier contact at a corner, so repeat until none is violated
+	bool adjusted = false;
+	for (int k = 0; k < iterations; k++) {
+		bool violated = false;
+		for (int i = 0; i < count; i++) {
+			double into = dx * contacts[i].nx + dy * contacts[i].ny;
+			if (into < 0) {
+				dx -= into * contacts[i].nx;
+				dy -= into * contacts[i].ny;
+				violated = true;
+			}
+		}
+		if (!violated) {
+			return adjusted;
+		}
+		adjusted = true;
+	}
+	// Still pushing into a contact after the last pass, so the camera is wedged in a corner and holds position
+	for (int i = 0; i < count; i++) {
+		if (dx * contacts[i].nx + dy * contacts[i].ny < -1e-9) {
+			dx = 0;
+			dy = 0;
+			break;
 		}
 	}
+	return adjusted;
 }
@@ -11,6 +11,7 @@
 #include <Windows.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include "binary_angle.h"
 #include "debug.h"
 
 enum CompareType {
@@ -45,6 +46,7 @@ public:
 
 	bool isInitialized() { return initialized; };
 	const int displacementFrom(const Point2d& p) { return (int)sqrt((int)(x - p.x) * (int)(x - p.x) + (int)(y - p.y) * (int)(y - p.y)); };
+	const int64_t squaredDisplacementFrom(const Point2d& p) const { int64_t dx = (int64_t)x - p.x; int64_t dy = (int64_t)y - p.y; return dx * dx + dy * dy; };
 
 private:
 	bool initialized = false;
@@ -67,21 +69,94 @@ public:
 class Ray2d : public Point2d {
 
 public:
-	double direction; // 0-360 degrees, 0 degrees aligned with positive x-axis, positive rotation moving towards positive y-axis (CW)
+	BinaryAngle direction; // Full turn in 65536 units, 0 aligned with positive x-axis, positive rotation moving towards positive y-axis (CW)
 
-	Ray2d() { x = 0; y = 0; direction = 0.0f; };
+	Ray2d() { x = 0; y = 0; direction = BinaryAngle(); };
 	Ray2d(const Ray2d& source) { x = source.x; y = source.y; direction = source.direction; };
-	Ray2d(uint32_t p_x, uint32_t p_y, float p_direction) { x = p_x; y = p_y; direction = p_direction; };
+	Ray2d(uint32_t p_x, uint32_t p_y, BinaryAngle p_direction) { x = p_x; y = p_y; direction = p_direction; };
 };
 
 struct Ray3d : public Point3d {
 
 public:
-	uint16_t yaw, pitch;
+	BinaryAngle yaw, pitch;
 
-	Ray3d() { x = 0; y = 0; z = 0; yaw = 0; pitch = 0; };
+	Ray3d() { x = 0; y = 0; z = 0; yaw = BinaryAngle(); pitch = BinaryAngle(); };
 	Ray3d(const Ray3d& source) { x = source.x; y = source.y; z = source.z; yaw = source.yaw; pitch = source.pitch; };
-	Ray3d(uint32_t p_x, uint32_t p_y, uint32_t p_z, uint16_t p_yaw, uint16_t p_pitch) { x = p_x; y = p_y; z = p_z; yaw = p_yaw; pitch = p_pitch; };
+	Ray3d(uint32_t p_x, uint32_t p_y, uint32_t p_z, BinaryAngle p_yaw, BinaryAngle p_pitch) { x = p_x; y = p_y; z = p_z; yaw = p_yaw; pitch = p_pitch; };
+};
+
+// Axis aligned bounds, inclusive on all sides. Default constructed bounds are empty and overlap nothing
+struct BoundingBox {
+	uint32_t minX, minY, maxX, maxY;
+
+	BoundingBox() { minX = UINT32_MAX; minY = UINT32_MAX; maxX = 0; maxY = 0; };
+	BoundingBox(uint32_t p_minX, uint32_t p_minY, uint32_t p_maxX, uint32_t p_maxY) { minX = p_minX; minY = p_minY; maxX = p_maxX; maxY = p_maxY; };
+
+	bool isEmpty() const { return minX > maxX || minY > maxY; };
+	bool overlaps(const BoundingBox& b) const { return minX <= b.maxX && b.minX <= maxX && minY <= b.maxY && b.minY <= maxY; };
+	bool contains(const Point2d& p) const { return p.x >= minX && p.x <= maxX && p.y >= minY && p.y <= maxY; };
+	bool contains(const BoundingBox& b) const { return b.minX >= minX && b.maxX <= maxX && b.minY >= minY && b.maxY <= maxY; };
+	void include(const Point2d& p) { minX = min(minX, p.x); minY = min(minY, p.y); maxX = max(maxX, p.x); maxY = max(maxY, p.y); };
+	double distanceSquared(const Point2d& p) const; // Zero inside
+	bool meetsSegment(const Point2d& p0, const Point2d& p1) const;
+};
+
+// Axis aligned run of pixels, fixed at one coordinate and covering from to to inclusive along the other
+struct Span {
+	uint32_t at;
+	uint32_t from, to;
+};
+
+// Sector swept clockwise from the ray at angle from to the ray at angle to, out to reach from the apex. The two rays
+// must be less than a half turn apart
+struct Wedge {
+	Point2d apex;
+	BinaryAngle from, to;
+	uint32_t reach = 0;
+
+	Wedge() {};
+	Wedge(const Point2d& p_apex, BinaryAngle p_from, BinaryAngle p_to, uint32_t p_reach);
+
+	bool containsAngle(BinaryAngle a) const { return (uint16_t)(a - from).value <= (uint16_t)(to - from).value; };
+	// Conservative: true for any box within reach and the wedge's bounds that no edge of the wedge separates from it
+	bool meets(const BoundingBox& b) const;
+	const BoundingBox& getBounds() const { return bounds; };
+
+private:
+	void calculateBounds();
+
+	double fromX = 1, fromY = 0, toX = 1, toY = 0; // Unit directions of the two rays
+	BoundingBox bounds;
+};
+
+// Cheap bounds test run ahead of any per-edge collision work, with counters to show how much of that work it saves
+namespace BroadPhase {
+
+	struct Stats {
+		uint64_t tests = 0;
+		uint64_t rejects = 0;
+	};
+
+	extern Stats stats;
+
+	bool test(const BoundingBox& a, const BoundingBox& b);
+	void reset();
+	std::string toString();
+};
+
+// Integer half-plane ax + by + c >= 0, oriented so that the interior of the owning shape is non-negative
+struct EdgeEquation {
+	int64_t a, b, c;
+
+	EdgeEquation() { a = 0; b = 0; c = 0; };
+	EdgeEquation(const Point2d& p0, const Point2d& p1) {
+		a = (int64_t)p0.y - p1.y;
+		b = (int64_t)p1.x - p0.x;
+		c = (int64_t)p0.x * p1.y - (int64_t)p1.x * p0.y;
+	};
+
+	int64_t evaluate(const Point2d& p) const { return a * p.x + b * p.y + c; };
 };
 
 class Line;
@@ -91,6 +166,8 @@ public:
 	int type;
 	std::vector<Point2d> vertices;
 	std::vector<Line> sides;
+	std::vector<EdgeEquation> edges;
+	BoundingBox bounds;
 
 	Geometry() { type = -1; };
 	Geometry(int p_type) { type = p_type; };
@@ -101,6 +178,8 @@ public:
 		for (int i = 0; i < source.vertices.size(); i++) {
 			vertices.push_back(source.vertices[i]);
 		}
+		edges = source.edges;
+		bounds = source.bounds;
 	};
 
 	enum GeometryType {
@@ -109,23 +188,30 @@ public:
 		G_RECT,
 		G_QUAD,
 		G_CIRCLE,
+		G_POLYGON,
 
 		G_NUM_TYPES,
 	};
 
 	virtual bool checkCollisionWith(const Point2d& p) = 0;
-	virtual void checkCollisionWith(Geometry* g, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) = 0;
+	// Batch hit tests: many points against this shape, or many shapes against one point
+	virtual void containsPoints(const std::vector<Point2d>& points, std::vector<uint8_t>& results);
+	static void containsPoint(const std::vector<Geometry*>& geometry, const Point2d& p, std::vector<Geometry*>& hits);
 
 protected:
+	void calculateBounds();
+	void calculateEdgeEquations();
+	bool checkEdgeEquations(const Point2d& p) const;
 	int comparePointsByCoordinate(CompareType compareType, const std::vector<Point2d>* v = nullptr, const Point2d* p1 = nullptr, const Point2d* p2 = nullptr, const int begin = -1, const int end = -1);
-	std::vector<float> calculateSlopes(const std::vector<Point2d> v_g);
-	void sortBySlope(std::vector<Point2d> &vertices, const std::vector<float> slopes);
+	static void calculateConvexHull(std::vector<Point2d>& points);
+	// Even-odd point test and convexity of the vertices in their current order, for outlines that may be concave
+	bool checkCrossingNumber(const Point2d& p) const;
+	bool calculateConvexity() const;
 	void createVertexShell();
 private:
 	int comparePointVectorByCoordinate(CompareType compare_type, const std::vector<Point2d>* v, const int begin = -1, const int end = -1);
 	int comparePointPairByCoordinate(CompareType compare_type, const Point2d* p1, const Point2d* p2);
 	uint8_t comparePointPairByCoordinates(const Point2d* p1, const Point2d* p2);
-	bool compareBySlope(float f1, float f2);
 };
 
 class Rect;
@@ -139,10 +225,11 @@ public:
 	Line(const Point2d& a, const Point2d& b);
 
 	bool checkCollisionWith(const Point2d& p);
-	void checkCollisionWith(Geometry* g, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides);
+	void containsPoints(const std::vector<Point2d>& points, std::vector<uint8_t>& results);
 	void checkCollisionWith(Rect r, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides);
 	void checkCollisionWith(Camera* c, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides);
 	void findIntersection(const Line& l, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides);
+	static void intersectSegments(const Point2d& p0, const Point2d& p1, const Point2d& q0, const Point2d& q1, Point2d& intersection);
 	Point2d findClosestPointOnLine(const Point2d& p);
 	double calculateSlope() { return static_cast<double>(getDy()) / getDx(); };
 	double calculateIntercept();
@@ -170,9 +257,7 @@ public:
 	Tri(const Geometry& source);
 	Tri(const Point2d& a, const Point2d& b, const Point2d& c);
 
-	// Currently unimplemented
-	bool checkCollisionWith(const Point2d& p) { return false; }
-	void checkCollisionWith(Geometry* g, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides);
+	bool checkCollisionWith(const Point2d& p) { return checkEdgeEquations(p); }
 };
 
 // Four-sided shape that assumes orthogonal sides 
@@ -193,40 +278,22 @@ public:
 	int getWidth() { return this->rb.x - this->lt.x; };
 	int getHeight() { return this->rb.y - this->lt.y; };
 	bool checkCollisionWith(const Point2d& p) { return (p.x >= lt.x && p.x <= rb.x && p.y >= lt.y && p.y <= rb.y); }
-	void checkCollisionWith(Geometry* g, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides);
 };
 
+// Always four vertices, which may be concave. Build a Poly from the points when their convex hull is wanted instead
 class Quad : public Geometry {
 	
 public:
+	bool convex = true;
+
 	Quad() {};
 	Quad(const Quad& source);
 	Quad(const Geometry& source);
-	Quad(const Point2d& a, const Point2d& b, const Point2d& c, const Point2d& d) : Geometry(G_QUAD) {
-
-		//// USE CONVEX HULL APPROACH TO SORT POINTS
-		//// FIND LOWEST Y COORD
-		//// CALCULATE SLOPE OF LINE FROM THAT POINT TO EACH OTHER POINT AND SORT 
-		//// should be sorted s.th. least negative -> most negative -> 1 -> most positive -> least positive
-		//vertices.push_back(&a);
-		//vertices.push_back(&b);
-		//vertices.push_back(&c);
-		//vertices.push_back(&d);
-
-		//int index_y = ComparePointsByCoordinate(0b101, &vertices);
-		//if (index_y != 0)
-		//	std::swap(*vertices.at(0), *vertices.at(index_y));
-		//
-		//std::vector<float> slope_vector = CalculateSlopes(vertices);
-		//SortBySlope(vertices, slope_vector);
-		///*for (int i = 0; i < slope_vector.size() - 1; i++) {
-		//	if (slope_vector[i] < 0 && slope_vector[i+1] < 0)
-		//		slope_vector[i] < slope_vector[i+1] ? 
-		//}*/
-	}
+	// Keeps the caller's order unless two sides would cross, then the first reordering whose sides do not
+	Quad(const Point2d& a, const Point2d& b, const Point2d& c, const Point2d& d);
 
-	bool checkCollisionWith(const Point2d& p) { return false; }
-	void checkCollisionWith(Geometry* g, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides);
+	bool checkCollisionWith(const Point2d& p) { return convex ? checkEdgeEquations(p) : checkCrossingNumber(p); }
+	void containsPoints(const std::vector<Point2d>& points, std::vector<uint8_t>& results);
 };
 
 class Circle : public Geometry {
@@ -243,13 +310,71 @@ public:
 	Circle(const Circle& source);
 	Circle(const Geometry& source);
 
-	bool checkCollisionWith(const Point2d& p) { return center.displacementFrom(p) <= r; }
-	void checkCollisionWith(Geometry* g, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides);
+	bool checkCollisionWith(const Point2d& p) { return center.squaredDisplacementFrom(p) <= (int64_t)r * r; }
+	void containsPoints(const std::vector<Point2d>& points, std::vector<uint8_t>& results);
+	// Closed form overlap tests, all performed on squared distances
+	bool intersectsSegment(const Point2d& a, const Point2d& b) const;
+	bool intersectsCircle(const Circle& c) const;
+	bool intersectsRect(const Rect& rect) const;
+	void findIntersections(const Point2d& a, const Point2d& b, std::vector<Point2d>& collisions, std::vector<Line>& interferingSides) const;
+	Point2d findClosestPointOnCircle(const Point2d& p) const;
+	Line calculateTangent(const Point2d& p) const;
 
 private:
 	void createVertexShell();
 };
 
+// Any number of vertices, either wrapped in their convex hull or kept in the given order as a simple polygon
+class Poly : public Geometry {
+
+public:
+	bool convex = true;
+
+	Poly() : Geometry(G_POLYGON) {};
+	Poly(const Poly& source);
+	Poly(const Geometry& source);
+	Poly(const std::vector<Point2d>& points, bool hull = true);
+
+	bool checkCollisionWith(const Point2d& p);
+	void containsPoints(const std::vector<Point2d>& points, std::vector<uint8_t>& results);
+};
+
+// Single point of contact between the camera and a shape. The edge handle indexes the side starting at
+// geometry->vertices[edge]; circles have no sides and use -1
+struct Contact {
+	Point2d point;
+	double nx, ny; // Unit normal pointing from the contact towards the camera center
+	double depth;
+	Geometry* geometry;
+	int16_t edge;
+
+	void calculateTangent(double& tx, double& ty) const;
+};
+
+// Fixed capacity, inline storage for every contact found in a frame. Cleared and refilled in place so that
+// collision bookkeeping never allocates
+class ContactManifold {
+
+public:
+	static const int CAPACITY = 32;
+	static const int SOLVER_ITERATIONS = 4;
+
+	ContactManifold() { count = 0; };
+
+	void clear() { count = 0; };
+	bool add(const Contact& c);
+	int size() const { return count; };
+	bool empty() const { return count == 0; };
+	bool isFull() const { return count == CAPACITY; };
+	const Contact& operator [] (int i) const { return contacts[i]; };
+	// Project the displacement onto the tangent of every contact it pushes into. Returns true if it was changed
+	bool resolveDisplacement(double& dx, double& dy, int iterations = SOLVER_ITERATIONS) const;
+
+private:
+	Contact contacts[CAPACITY];
+	int count;
+};
+
 class Camera : public Ray2d {
 
 	// Visual representation in top down panel, using an arrow to depict position and direction
@@ -267,22 +392,25 @@ public:
 	Line leftSide, rightSide, front, back;
 	uint8_t fov = 60;
 	uint16_t height = 10;
+	BoundingBox bounds; // Reach of collision tests around the camera center, refreshed by update()
 
-	Camera() { x = 0; y = 0; direction = 0.0f; size = 10; px = 0.0f; py = 0.0f; vx = 0.0f; vy = 0.0f; ax = 0.0f; ay = 0.0f; };
+	Camera() { x = 0; y = 0; direction = BinaryAngle(); size = 10; px = 0.0f; py = 0.0f; vx = 0.0f; vy = 0.0f; ax = 0.0f; ay = 0.0f; };
 	Camera(uint32_t p_x, uint32_t p_y, float p_direction);
 
 	void update();
+	Wedge getViewWedge(uint32_t reach) const; // Field of view around direction, out to reach
 
 	void setSize(uint8_t p_size) { size = p_size; };
-	void clampDirection();
 	void clampPosition(Rect panel);
 	void clampPosition(const Line& l, const Point2d collision);
 	void clampVelocity();
 	void clampAcceleration();
 	void clampAngularAcceleration();
 
-	void checkCollisionWith(Geometry* g, std::map<Point2d, std::vector<Line>>& collisions);
-	void findIntersection(Line& l, std::map<Point2d, std::vector<Line>>& collisions);
+	void checkCollisionWith(Geometry* g, ContactManifold& manifold);
+	void findIntersection(const Point2d& a, const Point2d& b, Geometry* g, int16_t edge, ContactManifold& manifold);
+	// Swept circle test over the motion (dx, dy). Returns true and narrows toi, a fraction of the motion, when g is hit first
+	bool sweep(Geometry* g, double dx, double dy, double& toi, Contact& contact) const;
 
 private:
 	uint8_t xOffset = 5;
@@ -290,6 +418,9 @@ private:
 	double theta = atan(yOffset / xOffset) * 180 / M_PI;      // angle of hypotenuse of right angle triangle formed by xOffset and yOffset
 	double c2C = sqrt(xOffset * xOffset + yOffset * yOffset); // centre of camera to corner of bounding box
 	Point2d boundingBox[4]; // lb, lt, rt, rb
+
+	bool sweepSegment(const Point2d& a, const Point2d& b, double dx, double dy, double& toi, Contact& contact) const;
+	bool sweepPoint(double ex, double ey, double radius, double dx, double dy, double& toi, Contact& contact) const;
 };
 
 #endif
\ No newline at end of file
@@ -1,19 +1,13 @@
 #include "input.h"
 
-void Input::clearInput(bool clear_held, bool clear_update, int key) {
-	int range_begin = 0;
-	int range_end = KEY_SIZE;
-	if (key != -1) {
-		range_begin = key;
-		range_end = key + 1;
-	}
-
-	for (int i = range_begin; i < range_end; i++) {
-		if (clear_held)
-			inputState[i].held = false;
-		if (clear_update)
-			inputState[i].update = false;
-	};
+Input::Input(Camera* p_camera) {
+	camera = p_camera;
+	// Waits for the tick count to change, so the two clocks are paired at the start of a tick rather than anywhere in it
+	uint32_t tick = GetTickCount();
+	do {
+		anchorTick = GetTickCount();
+	} while (anchorTick == tick);
+	anchorTime = InputQueue::now();
 }
 
 void Input::setInput(MSG* msg, bool is_held) {
@@ -24,11 +18,22 @@ void Input::setInput(MSG* msg, bool is_held) {
 		dbg.setMsg(msg);
 		Debug::Print(&dbg);
 
-		inputState[code].update = is_held != inputState[code].held;
-		inputState[code].held = is_held;
+		// The message is only drained at the start of the next frame, so the time it was posted is when the key changed
+		int64_t time = toQueueTime(msg->time);
+		// Moving the anchor to each message keeps the mapping the same, and the difference from it short enough never to wrap
+		anchorTick = (uint32_t)msg->time;
+		anchorTime = time;
+		lastTime = max(time, lastTime);
+		events.push({ lastTime, (uint8_t)code, is_held });
 	}
 }
 
+int64_t Input::toQueueTime(DWORD message_time) const {
+	// Signed, so a message from before the anchor comes out earlier, and the tick count's wrap every 49.7 days cancels
+	int32_t elapsed = (int32_t)((uint32_t)message_time - anchorTick);
+	return anchorTime + (int64_t)elapsed * 1000000;
+}
+
 bool Input::getInput(WPARAM wp) {
 	int code = vkToKey(wp);
 
@@ -38,32 +43,21 @@ bool Input::getInput(WPARAM wp) {
 	return false;
 }
 
-bool Input::getInput(int key_code) {
-	return inputState[key_code].held;
-}
-
 void Input::handleInput(MSG* msg, float dt) {
 	Debug::DebugMessage dbg = Debug::DebugMessage(CallingClasses::INPUT_CLASS, DebugTypes::INPUT_STATUS);
 	Debug::Print(&dbg);
 
-	double cosy = cos((camera->direction + 90) * M_PI / 180) * camera->moveSpeed;
-	double sinx = sin((camera->direction + 90) * M_PI / 180) * camera->moveSpeed;
+	double sinx, cosy;
+	(camera->direction + BinaryAngle(BinaryAngle::QUARTER_TURN)).sincos(sinx, cosy);
+	cosy *= camera->moveSpeed;
+	sinx *= camera->moveSpeed;
 
-	if (inputState[W_DOWN].held) {
-		camera->ay -= (float)cosy;
-		camera->ax += (float)sinx;
-	}
-	if (inputState[S_DOWN].held) {
-		camera->ay += (float)cosy;
-		camera->ax -= (float)sinx;
-	}
-	if (inputState[A_DOWN].held) {
-		camera->aa -= (float)camera->turnSpeed;
-	}
-	if (inputState[D_DOWN].held) {
-		camera->aa += (float)camera->turnSpeed;
-	}
-	//camera->clampDirection();
+	// Each key pushes for the share of the interval it was held, all of it for one held throughout
+	double forward = getForward();
+	double turn = getTurn();
+	camera->ay -= (float)(cosy * forward);
+	camera->ax += (float)(sinx * forward);
+	camera->aa += (float)(camera->turnSpeed * turn);
 }
 
 int Input::vkToKey(WPARAM w_param) {
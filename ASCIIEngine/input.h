@@ -3,43 +3,33 @@
 #include "Debug.h"
 #include <vector>
 #include "Geometry.h"
+#include "input_queue.h"
+#include "key_state.h"
 #define _USE_MATH_DEFINES
 #include <math.h>
 #ifndef ASCIIENGINE_INPUT_H_
 #define ASCIIENGINE_INPUT_H_
 
-enum Keys {
-	ML_DOWN,
-	W_DOWN,
-	A_DOWN,
-	S_DOWN,
-	D_DOWN,
-
-	KEY_SIZE,
-};
-
-class Input {
-
-	struct ButtonState {
-		bool held = false;
-		bool update = false;
-	};
+// Keyboard input from the window's messages, applied to the camera
+class Input : public KeyState {
 
 public:
-	Input(Camera* p_camera) {
-		camera = p_camera;
-	}
-
-	ButtonState inputState[KEY_SIZE];
+	Input(Camera* p_camera);
 
-	void clearInput(bool clear_held = true, bool clear_update = true, int key = -1);
+	// Stamps the key change with the time its message was posted and queues it, leaving inputState to consumeInput
 	void setInput(MSG* msg, bool is_held);
+	// A message time, in GetTickCount milliseconds, on InputQueue::now's clock
+	int64_t toQueueTime(DWORD message_time) const;
+	using KeyState::getInput;
 	bool getInput(WPARAM wp);
-	bool getInput(int key_code);
 	void handleInput(MSG* msg, float ms_per_frame);
 
 private:
 	Camera* camera;
+	// A time on the tick clock and the same time on the queue's clock, first sampled together as the tick count changed
+	uint32_t anchorTick;
+	int64_t anchorTime;
+	int64_t lastTime = INT64_MIN; // Latest stamp queued, so a stamp never goes back past an earlier one
 	int vkToKey(WPARAM wp);
 	void handleInput(int key_code);
 };
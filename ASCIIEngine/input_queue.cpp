@@ -0,0 +1,81 @@
+#include "input_queue.h"
+#include <chrono>
+
+int64_t InputQueue::now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool InputQueue::push(const InputEvent& e) {
+	uint32_t t = tail.load(std::memory_order_relaxed);
+	if (t - head.load(std::memory_order_acquire) == CAPACITY) {
+		dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	events[t & (CAPACITY - 1)] = e;
+	// Release the slot's contents along with the new tail
+	tail.store(t + 1, std::memory_order_release);
+	return true;
+}
+
+bool InputQueue::pop(InputEvent& e) {
+	uint32_t h = head.load(std::memory_order_relaxed);
+	if (h == tail.load(std::memory_order_acquire)) {
+		return false;
+	}
+	e = events[h & (CAPACITY - 1)];
+	// Hand the slot back to the producer only once it has been read
+	head.store(h + 1, std::memory_order_release);
+	return true;
+}
+
+bool InputQueue::popUntil(int64_t time, InputEvent& e) {
+	uint32_t h = head.load(std::memory_order_relaxed);
+	if (h == tail.load(std::memory_order_acquire) || events[h & (CAPACITY - 1)].time > time) {
+		return false;
+	}
+	e = events[h & (CAPACITY - 1)];
+	head.store(h + 1, std::memory_order_release);
+	return true;
+}
+
+void SyntheticInput::start(InputQueue& queue) {
+	stop();
+	stopping = false;
+	finished = false;
+	worker = std::thread(&SyntheticInput::replay, this, std::ref(queue));
+}
+
+void SyntheticInput::stop() {
+	stopping = true;
+	if (worker.joinable()) {
+		worker.join();
+	}
+}
+
+void SyntheticInput::replay(InputQueue& queue) {
+	// Steps are scheduled from the start rather than from when the last one was pushed, so late wakeups do not add up
+	auto due = std::chrono::steady_clock::now();
+	do {
+		for (const Step& step : script) {
+			due += std::chrono::nanoseconds(step.delay);
+			// Sleep in short slices so stop is never kept waiting on a long delay
+			for (auto t = std::chrono::steady_clock::now(); !stopping && t < due; t = std::chrono::steady_clock::now()) {
+				std::this_thread::sleep_until(due - t > std::chrono::milliseconds(10) ? t + std::chrono::milliseconds(10) : due);
+			}
+			if (stopping) {
+				return;
+			}
+			queue.push({ InputQueue::now(), step.key, step.held });
+		}
+	} while (repeat && !script.empty());
+	finished = true;
+}
+
+std::vector<SyntheticInput::Step> SyntheticInput::patrol(int64_t hold, int64_t gap) {
+	std::vector<Step> script;
+	for (uint8_t key : { W_DOWN, D_DOWN, S_DOWN, A_DOWN }) {
+		script.push_back({ gap, key, true });
+		script.push_back({ hold, key, false });
+	}
+	return script;
+}
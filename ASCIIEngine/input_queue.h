@@ -0,0 +1,85 @@
+#ifndef ASCIIENGINE_INPUT_QUEUE_H_
+#define ASCIIENGINE_INPUT_QUEUE_H_
+
+#include <atomic>
+#include <stdint.h>
+#include <thread>
+#include <vector>
+
+enum Keys {
+	ML_DOWN,
+	W_DOWN,
+	A_DOWN,
+	S_DOWN,
+	D_DOWN,
+
+	KEY_SIZE,
+};
+
+// A key going down or up, stamped when it was received
+struct InputEvent {
+	int64_t time; // Nanoseconds on InputQueue::now's clock
+	uint8_t key; // One of Keys
+	bool held;
+};
+
+// Fixed size ring of input events with one producer, the thread receiving input, and one consumer, the simulation.
+// Neither side locks or waits on the other. Events are popped in the order they were pushed, so their times never
+// go backwards, and a full queue drops the new event rather than blocking the producer
+class InputQueue {
+
+public:
+	static constexpr uint32_t CAPACITY = 256; // Power of two
+
+	// Steady high resolution clock, independent of the window and its messages
+	static int64_t now();
+
+	bool push(const InputEvent& e); // Producer only
+	bool pop(InputEvent& e); // Consumer only
+	bool popUntil(int64_t time, InputEvent& e); // Consumer only. Pops the oldest event if it happened no later than time
+	uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); };
+
+private:
+	InputEvent events[CAPACITY];
+	// Each index is written by one side only, and kept on its own cache line so the two sides do not contend for it
+	alignas(64) std::atomic<uint32_t> head{ 0 }; // Next event to pop
+	alignas(64) std::atomic<uint32_t> tail{ 0 }; // Next slot to fill
+	alignas(64) std::atomic<uint32_t> dropped{ 0 };
+};
+
+// Replays a script of key changes into a queue from a thread of its own, in place of a keyboard. Lets the input path
+// run without a window, as the producer side of the queue
+class SyntheticInput {
+
+public:
+	struct Step {
+		int64_t delay; // Nanoseconds after the previous step
+		uint8_t key;
+		bool held;
+	};
+
+	SyntheticInput(const std::vector<Step>& p_script, bool p_repeat = false) : script(p_script), repeat(p_repeat) {};
+	~SyntheticInput() { stop(); };
+	SyntheticInput(const SyntheticInput&) = delete;
+	SyntheticInput& operator = (const SyntheticInput&) = delete;
+
+	// Starts replaying from the first step. The queue must not be pushed to by anything else while running
+	void start(InputQueue& queue);
+	void stop();
+	bool isRunning() const { return worker.joinable(); };
+	bool isFinished() const { return finished.load(); };
+
+	// Walks forward and back while turning, each key held for hold nanoseconds with a pause of gap between them
+	static std::vector<Step> patrol(int64_t hold, int64_t gap);
+
+private:
+	void replay(InputQueue& queue);
+
+	std::vector<Step> script;
+	bool repeat;
+	std::thread worker;
+	std::atomic<bool> stopping{ false };
+	std::atomic<bool> finished{ false };
+};
+
+#endif
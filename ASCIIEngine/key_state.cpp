@@ -0,0 +1,48 @@
+#include "key_state.h"
+
+void KeyState::clearInput(bool clear_held, bool clear_update, int key) {
+	int range_begin = 0;
+	int range_end = KEY_SIZE;
+	if (key != -1) {
+		range_begin = key;
+		range_end = key + 1;
+	}
+
+	for (int i = range_begin; i < range_end; i++) {
+		if (clear_held)
+			inputState[i].held = false;
+		if (clear_update)
+			inputState[i].update = false;
+	};
+}
+
+void KeyState::consumeInput(int64_t from, int64_t to) {
+	int64_t since[KEY_SIZE];
+	for (int i = 0; i < KEY_SIZE; i++) {
+		since[i] = from;
+		inputState[i].heldFor = 0;
+	}
+	double length = to > from ? (double)(to - from) : 0;
+	InputEvent e;
+	while (events.popUntil(to, e)) {
+		ButtonState& state = inputState[e.key];
+		// Anything stamped before the interval began counts from its start
+		int64_t time = e.time > from ? e.time : from;
+		if (state.held) {
+			state.heldFor += time - since[e.key];
+		}
+		since[e.key] = time;
+		state.update = state.update || e.held != state.held;
+		state.held = e.held;
+	}
+	for (int i = 0; i < KEY_SIZE; i++) {
+		if (inputState[i].held) {
+			inputState[i].heldFor += to - since[i];
+		}
+		inputState[i].heldFor = length > 0 ? inputState[i].heldFor / length : (inputState[i].held ? 1.0 : 0.0);
+	}
+}
+
+bool KeyState::getInput(int key_code) {
+	return inputState[key_code].held;
+}
@@ -0,0 +1,57 @@
+#ifndef ASCIIENGINE_KEY_STATE_H_
+#define ASCIIENGINE_KEY_STATE_H_
+
+#include <chrono>
+#include <stdint.h>
+#include <thread>
+#include "input_queue.h"
+
+// Which keys are held and for how much of each frame, built from the key changes in a queue. Uses no window or message
+// types, so the input path can be driven and checked without Windows; Input adds the window's keyboard on top
+class KeyState {
+
+	struct ButtonState {
+		bool held = false;
+		bool update = false;
+		double heldFor = 0; // Share of the last consumed interval the key was held for
+	};
+
+public:
+	ButtonState inputState[KEY_SIZE];
+	InputQueue events; // Key changes waiting for the simulation, pushed by whichever thread receives them
+
+	void clearInput(bool clear_held = true, bool clear_update = true, int key = -1);
+	// Applies queued changes made up to time to, crediting each key with the part of the interval since from it was
+	// held for, so a press late in a frame moves the camera for only the time it was down
+	void consumeInput(int64_t from, int64_t to);
+	bool getInput(int key_code);
+	// Net push along and around the view over the last consumed interval, each between -1 and 1
+	double getForward() const { return inputState[W_DOWN].heldFor - inputState[S_DOWN].heldFor; };
+	double getTurn() const { return inputState[D_DOWN].heldFor - inputState[A_DOWN].heldFor; };
+
+	// Runs the input path with no window: source replays its script into events from its own thread while this one
+	// consumes them every frameLength nanoseconds, as the main loop does, calling frame() after each consume until the
+	// script has played out. The script must not repeat. Returns the number of frames run
+	template <typename Frame>
+	uint32_t replay(SyntheticInput& source, int64_t frameLength, Frame frame);
+};
+
+template <typename Frame>
+uint32_t KeyState::replay(SyntheticInput& source, int64_t frameLength, Frame frame) {
+	uint32_t frames = 0;
+	int64_t from = InputQueue::now();
+	source.start(events);
+	for (bool finished = false; !finished; frames++) {
+		// Checked before the frame ends, so every change the source made is stamped before the last frame's end
+		finished = source.isFinished();
+		int64_t to = from + frameLength;
+		std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(to))));
+		consumeInput(from, to);
+		frame();
+		from = to;
+	}
+	source.stop();
+	return frames;
+}
+
+#endif
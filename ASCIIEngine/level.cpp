@@ -0,0 +1,266 @@
+#include "level.h"
+#include <cstring>
+#include "mapped_file.h"
+
+// Anonymous namespace to hide internal helper functions
+namespace {
+	const uint16_t MAX_POLYGON_VERTICES = 1024;
+	const uint32_t MAX_VALUES = MAX_POLYGON_VERTICES * 2;
+
+	bool loadBinary(const uint8_t* begin, const uint8_t* end, std::vector<Geometry*>& geometry) {
+		Level::FileHeader header;
+		if ((size_t)(end - begin) < sizeof(header)) {
+			return false;
+		}
+		memcpy(&header, begin, sizeof(header));
+		if (header.version != Level::VERSION) {
+			return false;
+		}
+		// The count is only trusted as far as the file has room for that many records
+		size_t room = (size_t)(end - begin - sizeof(header)) / sizeof(Level::RecordHeader);
+		geometry.reserve(geometry.size() + min((size_t)header.recordCount, room));
+
+		// Records are read in place from the mapped view; only the shapes themselves are allocated
+		std::vector<Point2d> points;
+		points.reserve(MAX_POLYGON_VERTICES);
+		uint32_t values[MAX_VALUES];
+		const uint8_t* p = begin + sizeof(header);
+		for (uint32_t i = 0; i < header.recordCount; i++) {
+			Level::RecordHeader record;
+			if ((size_t)(end - p) < sizeof(record)) {
+				return false;
+			}
+			memcpy(&record, p, sizeof(record));
+			p += sizeof(record);
+			size_t length = (size_t)record.valueCount * sizeof(uint32_t);
+			if (record.valueCount > MAX_VALUES || (size_t)(end - p) < length) {
+				return false;
+			}
+			memcpy(values, p, length);
+			p += length;
+
+			Geometry* g = Level::createGeometry(record.type, values, record.valueCount, points);
+			if (!g) {
+				return false;
+			}
+			geometry.push_back(g);
+		}
+		return true;
+	}
+
+	// Cursor over the mapped text, skipping spaces, tabs and comments but stopping at line ends
+	struct TextCursor {
+		const uint8_t* p;
+		const uint8_t* end;
+
+		void skipSpace() {
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) {
+				p++;
+			}
+			if (p < end && *p == '#') {
+				while (p < end && *p != '\n') {
+					p++;
+				}
+			}
+		}
+		bool atLineEnd() {
+			skipSpace();
+			return p == end || *p == '\n';
+		}
+		void nextLine() {
+			while (p < end && *p != '\n') {
+				p++;
+			}
+			if (p < end) {
+				p++;
+			}
+		}
+		bool readWord(const char*& word, size_t& length) {
+			skipSpace();
+			word = reinterpret_cast<const char*>(p);
+			while (p < end && ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z'))) {
+				p++;
+			}
+			length = reinterpret_cast<const char*>(p) - word;
+			return length > 0;
+		}
+		bool readValue(uint32_t& value) {
+			skipSpace();
+			uint64_t result = 0;
+			const uint8_t* start = p;
+			while (p < end && *p >= '0' && *p <= '9' && result <= UINT32_MAX) {
+				result = result * 10 + (*p - '0');
+				p++;
+			}
+			value = (uint32_t)result;
+			return p != start && result <= UINT32_MAX;
+		}
+	};
+
+	int keywordType(const char* word, size_t length) {
+		const char* keywords[Geometry::G_NUM_TYPES] = { "line", "tri", "rect", "quad", "circle", "poly" };
+		for (int i = 0; i < Geometry::G_NUM_TYPES; i++) {
+			if (strlen(keywords[i]) == length && strncmp(keywords[i], word, length) == 0) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+	bool loadText(const uint8_t* begin, const uint8_t* end, std::vector<Geometry*>& geometry) {
+		std::vector<Point2d> points;
+		points.reserve(MAX_POLYGON_VERTICES);
+		uint32_t values[MAX_VALUES];
+		const uint32_t fixedCounts[Geometry::G_NUM_TYPES] = { 4, 6, 4, 8, 3, 0 };
+
+		TextCursor cursor = { begin, end };
+		for (; cursor.p < cursor.end; cursor.nextLine()) {
+			if (cursor.atLineEnd()) {
+				continue;
+			}
+			const char* word;
+			size_t length;
+			int type = cursor.readWord(word, length) ? keywordType(word, length) : -1;
+			if (type < 0) {
+				return false;
+			}
+			uint32_t count = fixedCounts[type];
+			if (type == Geometry::G_POLYGON) {
+				uint32_t vertexCount;
+				if (!cursor.readValue(vertexCount) || vertexCount > MAX_POLYGON_VERTICES) {
+					return false;
+				}
+				count = vertexCount * 2;
+			}
+			for (uint32_t i = 0; i < count; i++) {
+				if (!cursor.readValue(values[i])) {
+					return false;
+				}
+			}
+			Geometry* g = Level::createGeometry((uint8_t)type, values, count, points);
+			if (!g || !cursor.atLineEnd()) {
+				delete g;
+				return false;
+			}
+			geometry.push_back(g);
+		}
+		return true;
+	}
+}
+
+bool Level::load(const char* path, std::vector<Geometry*>& geometry) {
+	MappedFile file;
+	if (!file.open(path)) {
+		return false;
+	}
+	uint32_t magic = 0;
+	if (file.getSize() >= sizeof(magic)) {
+		memcpy(&magic, file.begin(), sizeof(magic));
+	}
+	if (magic == MAGIC) {
+		return loadBinary(file.begin(), file.end(), geometry);
+	}
+	return loadText(file.begin(), file.end(), geometry);
+}
+
+Geometry* Level::createGeometry(uint8_t type, const uint32_t* v, uint32_t count, std::vector<Point2d>& points) {
+	switch (type) {
+	case (Geometry::G_LINE):
+	{
+		if (count != 4) return nullptr;
+		return new Line(Point2d(v[0], v[1]), Point2d(v[2], v[3]));
+	}
+	case (Geometry::G_TRI):
+	{
+		if (count != 6) return nullptr;
+		return new Tri(Point2d(v[0], v[1]), Point2d(v[2], v[3]), Point2d(v[4], v[5]));
+	}
+	case (Geometry::G_RECT):
+	{
+		if (count != 4) return nullptr;
+		return new Rect(Point2d(v[0], v[1]), Point2d(v[2], v[3]));
+	}
+	case (Geometry::G_QUAD):
+	{
+		if (count != 8) return nullptr;
+		return new Quad(Point2d(v[0], v[1]), Point2d(v[2], v[3]), Point2d(v[4], v[5]), Point2d(v[6], v[7]));
+	}
+	case (Geometry::G_CIRCLE):
+	{
+		if (count != 3 || v[2] == 0 || v[2] > UINT16_MAX) return nullptr;
+		return new Circle(Point2d(v[0], v[1]), (uint16_t)v[2]);
+	}
+	case (Geometry::G_POLYGON):
+	{
+		if (count < 6 || count % 2 != 0 || count > MAX_VALUES) return nullptr;
+		points.clear();
+		for (uint32_t i = 0; i < count; i += 2) {
+			points.push_back(Point2d(v[i], v[i + 1]));
+		}
+		return new Poly(points, false);
+	}
+	default:
+		return nullptr;
+	}
+}
+
+bool Level::writeValues(const Geometry* g, std::vector<uint32_t>& values) {
+	switch (g->type) {
+	case (Geometry::G_RECT):
+	{
+		const Rect* r = static_cast<const Rect*>(g);
+		values.insert(values.end(), { r->lt.x, r->lt.y, r->rb.x, r->rb.y });
+	} break;
+	case (Geometry::G_QUAD):
+	{
+		// The four points createGeometry expects, in their stored order so a concave quad reloads unchanged
+		if (g->vertices.size() != 4) {
+			return false;
+		}
+		const std::vector<Point2d>& v = g->vertices;
+		values.insert(values.end(), { v[0].x, v[0].y, v[1].x, v[1].y, v[2].x, v[2].y, v[3].x, v[3].y });
+	} break;
+	case (Geometry::G_CIRCLE):
+	{
+		const Circle* c = static_cast<const Circle*>(g);
+		values.insert(values.end(), { c->center.x, c->center.y, (uint32_t)c->r });
+	} break;
+	default:
+	{
+		for (const Point2d& v : g->vertices) {
+			values.push_back(v.x);
+			values.push_back(v.y);
+		}
+	} break;
+	}
+	return true;
+}
+
+bool Level::saveBinary(const char* path, const std::vector<Geometry*>& geometry) {
+	std::vector<uint8_t> buffer;
+	FileHeader header = { MAGIC, VERSION, 0, (uint32_t)geometry.size() };
+	buffer.resize(sizeof(header));
+	memcpy(buffer.data(), &header, sizeof(header));
+
+	std::vector<uint32_t> values;
+	for (Geometry* g : geometry) {
+		values.clear();
+		if (!writeValues(g, values)) {
+			return false;
+		}
+		RecordHeader record = { (uint8_t)g->type, 0, (uint16_t)values.size() };
+		size_t recordStart = buffer.size();
+		buffer.resize(recordStart + sizeof(record) + values.size() * sizeof(uint32_t));
+		memcpy(buffer.data() + recordStart, &record, sizeof(record));
+		memcpy(buffer.data() + recordStart + sizeof(record), values.data(), values.size() * sizeof(uint32_t));
+	}
+
+	HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	DWORD written = 0;
+	bool result = WriteFile(file, buffer.data(), (DWORD)buffer.size(), &written, nullptr) && written == buffer.size();
+	CloseHandle(file);
+	return result;
+}
@@ -0,0 +1,50 @@
+#ifndef ASCIIENGINE_LEVEL_H_
+#define ASCIIENGINE_LEVEL_H_
+
+#include <stdint.h>
+#include <vector>
+#include "geometry.h"
+
+// Level files hold shapes in one of two formats, told apart by the leading magic number.
+//
+// Text, one shape per line, '#' starts a comment:
+//	line x0 y0 x1 y1
+//	tri x0 y0 x1 y1 x2 y2
+//	rect x0 y0 x1 y1
+//	quad x0 y0 x1 y1 x2 y2 x3 y3
+//	circle cx cy r
+//	poly n x0 y0 ... xn-1 yn-1
+//
+// Binary, little endian: a FileHeader followed by recordCount records. Each record is a RecordHeader and then
+// valueCount uint32 values, laid out in the same order as the text format (poly values are the points only)
+namespace Level {
+
+	const uint32_t MAGIC = 0x4C435341; // "ASCL"
+	const uint16_t VERSION = 1;
+
+	struct FileHeader {
+		uint32_t magic;
+		uint16_t version;
+		uint16_t reserved;
+		uint32_t recordCount;
+	};
+
+	struct RecordHeader {
+		uint8_t type; // Geometry::GeometryType
+		uint8_t reserved;
+		uint16_t valueCount;
+	};
+
+	// Append every shape in the file to geometry. Returns false if the file cannot be read or is malformed,
+	// keeping whatever was parsed before the error
+	bool load(const char* path, std::vector<Geometry*>& geometry);
+	// Fails, writing nothing, if any shape cannot be stored
+	bool saveBinary(const char* path, const std::vector<Geometry*>& geometry);
+
+	// Shape from its record values, reusing points as scratch for polygons. Returns nullptr for malformed values
+	Geometry* createGeometry(uint8_t type, const uint32_t* values, uint32_t count, std::vector<Point2d>& points);
+	// Append the record values describing g. Returns false, appending nothing, if g cannot be described by a record
+	bool writeValues(const Geometry* g, std::vector<uint32_t>& values);
+};
+
+#endif
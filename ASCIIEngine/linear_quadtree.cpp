@@ -0,0 +1,211 @@
+#include "linear_quadtree.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+// Anonymous namespace to hide internal helper functions
+namespace {
+	const int RADIX_BITS = 8;
+	const int RADIX_BUCKETS = 1 << RADIX_BITS;
+
+	// Spread the 32 bits of v over the even bits of the result
+	uint64_t spreadBits(uint32_t v) {
+		uint64_t x = v;
+		x = (x | (x << 16)) & 0x0000FFFF0000FFFFull;
+		x = (x | (x << 8)) & 0x00FF00FF00FF00FFull;
+		x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0Full;
+		x = (x | (x << 2)) & 0x3333333333333333ull;
+		x = (x | (x << 1)) & 0x5555555555555555ull;
+		return x;
+	}
+
+	uint32_t compactBits(uint64_t x) {
+		x &= 0x5555555555555555ull;
+		x = (x | (x >> 1)) & 0x3333333333333333ull;
+		x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+		x = (x | (x >> 4)) & 0x00FF00FF00FF00FFull;
+		x = (x | (x >> 8)) & 0x0000FFFF0000FFFFull;
+		x = (x | (x >> 16)) & 0x00000000FFFFFFFFull;
+		return (uint32_t)x;
+	}
+
+	unsigned threadsFor(size_t count) {
+		unsigned available = max(std::thread::hardware_concurrency(), 1u);
+		return (unsigned)max((size_t)1, min((size_t)available, count / LinearQuadtree::MIN_CHUNK));
+	}
+
+	// Run f(t, begin, end) over threads even slices of [0, count), the last on the calling thread
+	template <typename F>
+	void parallelFor(unsigned threads, size_t count, F f) {
+		std::vector<std::thread> workers;
+		for (unsigned t = 0; t + 1 < threads; t++) {
+			workers.push_back(std::thread(f, t, count * t / threads, count * (t + 1) / threads));
+		}
+		f(threads - 1, count * (threads - 1) / threads, count);
+		for (std::thread& w : workers) {
+			w.join();
+		}
+	}
+
+	// Least significant digit first, each pass a per thread histogram, an exclusive scan across threads and digits,
+	// then a stable scatter of every thread's slice. Passes whose digit is the same for every key are skipped, which
+	// for world sized coordinates is most of the upper half of the key
+	void radixSort(std::vector<LinearQuadtree::Entry>& entries) {
+		size_t count = entries.size();
+		std::vector<LinearQuadtree::Entry> scratch(count);
+		unsigned threads = threadsFor(count);
+		std::vector<size_t> histograms(threads * RADIX_BUCKETS);
+		for (int shift = 0; shift < 64; shift += RADIX_BITS) {
+			std::fill(histograms.begin(), histograms.end(), 0);
+			parallelFor(threads, count, [&](unsigned t, size_t begin, size_t end) {
+				size_t* histogram = &histograms[t * RADIX_BUCKETS];
+				for (size_t i = begin; i < end; i++) {
+					histogram[(entries[i].key >> shift) & (RADIX_BUCKETS - 1)]++;
+				}
+			});
+
+			size_t offset = 0;
+			bool trivial = false;
+			for (int digit = 0; digit < RADIX_BUCKETS; digit++) {
+				size_t digitTotal = 0;
+				for (unsigned t = 0; t < threads; t++) {
+					size_t c = histograms[t * RADIX_BUCKETS + digit];
+					histograms[t * RADIX_BUCKETS + digit] = offset;
+					offset += c;
+					digitTotal += c;
+				}
+				trivial = trivial || digitTotal == count;
+			}
+			if (trivial) {
+				continue;
+			}
+
+			parallelFor(threads, count, [&](unsigned t, size_t begin, size_t end) {
+				size_t* next = &histograms[t * RADIX_BUCKETS];
+				for (size_t i = begin; i < end; i++) {
+					scratch[next[(entries[i].key >> shift) & (RADIX_BUCKETS - 1)]++] = entries[i];
+				}
+			});
+			entries.swap(scratch);
+		}
+	}
+
+	struct SerializedHeader {
+		uint32_t count;
+		uint32_t reachExtent;
+	};
+}
+
+uint64_t LinearQuadtree::encode(uint32_t x, uint32_t y) {
+	return spreadBits(x) | (spreadBits(y) << 1);
+}
+
+void LinearQuadtree::decode(uint64_t key, uint32_t& x, uint32_t& y) {
+	x = compactBits(key);
+	y = compactBits(key >> 1);
+}
+
+void LinearQuadtree::build(const std::vector<Geometry*>& geometry) {
+	size_t count = geometry.size();
+	shapes = geometry;
+	entries.resize(count);
+	bounds.resize(count);
+	unsigned threads = threadsFor(count);
+
+	// Key every shape by its centre, and find the furthest any bounds reach from their centre
+	std::vector<uint32_t> extents(threads, 0);
+	parallelFor(threads, count, [&](unsigned t, size_t begin, size_t end) {
+		uint32_t extent = 0;
+		for (size_t i = begin; i < end; i++) {
+			const BoundingBox& b = geometry[i]->bounds;
+			uint32_t halfWidth = (b.maxX - b.minX + 1) / 2, halfHeight = (b.maxY - b.minY + 1) / 2;
+			entries[i].key = encode(b.minX + halfWidth, b.minY + halfHeight);
+			entries[i].index = (uint32_t)i;
+			entries[i].reserved = 0;
+			extent = max(extent, max(halfWidth, halfHeight));
+		}
+		extents[t] = extent;
+	});
+	reachExtent = *std::max_element(extents.begin(), extents.end());
+
+	radixSort(entries);
+	parallelFor(threads, count, [&](unsigned t, size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			bounds[i] = geometry[entries[i].index]->bounds;
+		}
+	});
+}
+
+void LinearQuadtree::queryRect(const BoundingBox& box, std::vector<Geometry*>& results) const {
+	if (box.isEmpty() || entries.empty()) {
+		return;
+	}
+	// Centres of shapes overlapping box lie within reachExtent of it
+	BoundingBox reach(box.minX - min(box.minX, reachExtent), box.minY - min(box.minY, reachExtent),
+		box.maxX + min(UINT32_MAX - box.maxX, reachExtent), box.maxY + min(UINT32_MAX - box.maxY, reachExtent));
+	queryCell(0, 32, 0, entries.size(), reach, box, results);
+}
+
+void LinearQuadtree::queryCell(uint64_t prefix, int level, size_t first, size_t last, const BoundingBox& reach, const BoundingBox& box, std::vector<Geometry*>& results) const {
+	// The cell at this level spans 2^level keys along each axis from the point its prefix decodes to
+	uint32_t x, y;
+	decode(prefix, x, y);
+	uint64_t span = ((uint64_t)1 << level) - 1;
+	if (x > reach.maxX || y > reach.maxY || x + span < reach.minX || y + span < reach.minY) {
+		return;
+	}
+	bool inside = x >= reach.minX && y >= reach.minY && x + span <= reach.maxX && y + span <= reach.maxY;
+	if (inside || level == 0 || last - first <= SCAN_THRESHOLD) {
+		for (size_t i = first; i < last; i++) {
+			if (box.overlaps(bounds[i])) {
+				results.push_back(shapes[entries[i].index]);
+			}
+		}
+		return;
+	}
+
+	// Split the run among the four children, each a binary search within what is left of it
+	uint64_t childKeys = (uint64_t)1 << (2 * (level - 1));
+	for (uint64_t c = 0; c < 4 && first < last; c++) {
+		uint64_t childEnd = prefix + (c + 1) * childKeys - 1;
+		size_t childLast = std::upper_bound(entries.begin() + first, entries.begin() + last, childEnd, [](uint64_t key, const Entry& e) { return key < e.key; }) - entries.begin();
+		queryCell(prefix + c * childKeys, level - 1, first, childLast, reach, box, results);
+		first = childLast;
+	}
+}
+
+void LinearQuadtree::serialize(std::vector<uint8_t>& buffer) const {
+	SerializedHeader header = { (uint32_t)entries.size(), reachExtent };
+	size_t start = buffer.size();
+	buffer.resize(start + sizeof(header) + entries.size() * (sizeof(Entry) + sizeof(BoundingBox)));
+	uint8_t* p = buffer.data() + start;
+	memcpy(p, &header, sizeof(header));
+	p += sizeof(header);
+	memcpy(p, entries.data(), entries.size() * sizeof(Entry));
+	p += entries.size() * sizeof(Entry);
+	memcpy(p, bounds.data(), bounds.size() * sizeof(BoundingBox));
+}
+
+bool LinearQuadtree::deserialize(const uint8_t* data, size_t size, const std::vector<Geometry*>& geometry) {
+	SerializedHeader header;
+	if (size < sizeof(header)) {
+		return false;
+	}
+	memcpy(&header, data, sizeof(header));
+	if ((size - sizeof(header)) / (sizeof(Entry) + sizeof(BoundingBox)) < header.count) {
+		return false;
+	}
+	std::vector<Entry> loaded(header.count);
+	memcpy(loaded.data(), data + sizeof(header), header.count * sizeof(Entry));
+	for (size_t i = 0; i < loaded.size(); i++) {
+		if (loaded[i].index >= geometry.size() || (i > 0 && loaded[i].key < loaded[i - 1].key)) {
+			return false;
+		}
+	}
+	entries.swap(loaded);
+	bounds.resize(header.count);
+	memcpy(bounds.data(), data + sizeof(header) + header.count * sizeof(Entry), header.count * sizeof(BoundingBox));
+	shapes = geometry;
+	reachExtent = header.reachExtent;
+	return true;
+}
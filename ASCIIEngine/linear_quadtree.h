@@ -0,0 +1,46 @@
+#ifndef ASCIIENGINE_LINEAR_QUADTREE_H_
+#define ASCIIENGINE_LINEAR_QUADTREE_H_
+
+#include <stdint.h>
+#include <vector>
+#include "geometry.h"
+
+// Pointerless quadtree over shape bounds for scenes built all at once. Each shape is keyed by the Morton (Z-order)
+// code of its bounds centre and the keys kept sorted, so every quadrant at every depth is one contiguous run of
+// entries, found by binary search
+class LinearQuadtree {
+
+public:
+	struct Entry {
+		uint64_t key;
+		uint32_t index; // Into the geometry the tree was built from
+		uint32_t reserved;
+	};
+
+	static const uint32_t SCAN_THRESHOLD = 16; // Runs no longer than this are filtered directly instead of divided further
+	static const size_t MIN_CHUNK = 1 << 16; // Fewest entries worth handing to another thread while building
+
+	// x in the even bits, y in the odd bits
+	static uint64_t encode(uint32_t x, uint32_t y);
+	static void decode(uint64_t key, uint32_t& x, uint32_t& y);
+
+	// Replaces the contents with the given shapes, keyed in parallel and ordered by a parallel radix sort
+	void build(const std::vector<Geometry*>& geometry);
+	// Appends every shape whose bounds overlap box, in Morton order of their centres
+	void queryRect(const BoundingBox& box, std::vector<Geometry*>& results) const;
+	size_t size() const { return entries.size(); };
+
+	// The entries and bounds as flat arrays. Shapes are stored by index and attached again from the same geometry on load
+	void serialize(std::vector<uint8_t>& buffer) const;
+	bool deserialize(const uint8_t* data, size_t size, const std::vector<Geometry*>& geometry);
+
+private:
+	void queryCell(uint64_t prefix, int level, size_t first, size_t last, const BoundingBox& reach, const BoundingBox& box, std::vector<Geometry*>& results) const;
+
+	std::vector<Entry> entries;
+	std::vector<BoundingBox> bounds; // In entry order, so filtering a run reads them contiguously
+	std::vector<Geometry*> shapes;
+	uint32_t reachExtent = 0; // No shape's bounds reach further than this from its centre
+};
+
+#endif
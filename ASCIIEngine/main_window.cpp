@@ -3,6 +3,9 @@
 #include <string>
 #include "renderer.h"
 #include "debug.h"
+#include "benchmark.h"
+#include "collision.h"
+#include "level.h"
 
 // Window procedure
 LRESULT CALLBACK WndProc(_In_ HWND hwnd, _In_ UINT msg, _In_ WPARAM wParam, _In_ LPARAM lParam) {
@@ -59,6 +62,75 @@ LRESULT CALLBACK WndProc(_In_ HWND hwnd, _In_ UINT msg, _In_ WPARAM wParam, _In_
 			// allow debug messaging toggle
 			Debug::ToggleDebugPrinting();
 		} break;
+		case (VK_F1):
+		{
+			Benchmark::collisionResponse();
+		} break;
+		case (VK_F2):
+		{
+			Benchmark::levelImport();
+		} break;
+		case (VK_F4):
+		{
+			Benchmark::spatialQueries();
+		} break;
+		case (VK_F5):
+		{
+			Benchmark::linearQuadtree();
+		} break;
+		case (VK_F6):
+		{
+			Benchmark::quadtreeTuning();
+		} break;
+		case (VK_F7):
+		{
+			Benchmark::batchUpdate();
+			Benchmark::publishedReaders();
+		} break;
+		case (VK_F8):
+		{
+			Benchmark::spatialIndexes();
+		} break;
+		case (VK_F9):
+		{
+			Benchmark::firstPerson();
+		} break;
+		case (VK_F11):
+		{
+			Benchmark::inputLatency();
+		} break;
+		case (VK_F3):
+		{
+			MW::saveSnapshot("scene.snapshot");
+		} break;
+		case (VK_LEFT):
+		{
+			MW::view.pan(-MW::panStep, 0);
+		} break;
+		case (VK_RIGHT):
+		{
+			MW::view.pan(MW::panStep, 0);
+		} break;
+		case (VK_UP):
+		{
+			MW::view.pan(0, -MW::panStep);
+		} break;
+		case (VK_DOWN):
+		{
+			MW::view.pan(0, MW::panStep);
+		} break;
+		case (VK_PRIOR):
+		{
+			MW::view.zoomBy(Viewport::ZOOM_STEP);
+		} break;
+		case (VK_NEXT):
+		{
+			MW::view.zoomBy(1.0 / Viewport::ZOOM_STEP);
+		} break;
+		case (VK_HOME):
+		{
+			MW::view.reset();
+		} break;
 		case (0x4C):
 		{
 			// 'L'
@@ -104,6 +176,10 @@ LRESULT CALLBACK WndProc(_In_ HWND hwnd, _In_ UINT msg, _In_ WPARAM wParam, _In_
 		} break;
 		}
 	} break;
+	case WM_MOUSEWHEEL:
+	{
+		MW::view.zoomBy(GET_WHEEL_DELTA_WPARAM(wParam) > 0 ? Viewport::ZOOM_STEP : 1.0 / Viewport::ZOOM_STEP);
+	} break;
 	case WM_MOUSEMOVE:
 	{
 		Debug::DebugMessage dbg(CallingClasses::MAIN_WINDOW_CLASS, DebugTypes::MOUSE_POSITION);
@@ -131,14 +207,12 @@ LRESULT CALLBACK WndProc(_In_ HWND hwnd, _In_ UINT msg, _In_ WPARAM wParam, _In_
 	} break;
 	case WM_LBUTTONDOWN:
 	{
-		bool insideExistingGeometry = false;
-		Point2d start = MW::eventMessage.pt;
-		for (const auto g : MW::geometryQueue) {
-			if (g->checkCollisionWith(start)) {
-				// Disallow starting new geometry when starting from insde existing geometry
-				insideExistingGeometry = true;
-			}
-		}
+		Point2d start = MW::view.toWorld(MW::eventMessage.pt);
+		// Disallow starting new geometry when starting from insde existing geometry
+		std::vector<Geometry*> candidates, hits;
+		MW::spatialIndex->queryRect(BoundingBox(start.x, start.y, start.x, start.y), candidates);
+		Geometry::containsPoint(candidates, start, hits);
+		bool insideExistingGeometry = !hits.empty();
 		{
 			Debug::DebugMessage dbg(CallingClasses::MAIN_WINDOW_CLASS, DebugTypes::INPUT_DETECTED);
 			dbg.setMsg(&MW::eventMessage);
@@ -186,6 +260,9 @@ LRESULT CALLBACK WndProc(_In_ HWND hwnd, _In_ UINT msg, _In_ WPARAM wParam, _In_
 
 			if (MW::geoStart.displacementFrom(MW::geoEnd) > 10) {
 				Geometry* g;
+				// The highlight line is drawn on screen, the shape is placed in the world
+				Point2d a = MW::view.toWorld(MW::highlightLine.vertices.at(0));
+				Point2d c = MW::view.toWorld(MW::highlightLine.vertices.at(1));
 
 				Debug::DebugMessage dbg(MAIN_WINDOW_CLASS, GEO_QUEUE_MOD);
 				dbg.setMsg(&MW::eventMessage);
@@ -195,24 +272,24 @@ LRESULT CALLBACK WndProc(_In_ HWND hwnd, _In_ UINT msg, _In_ WPARAM wParam, _In_
 				switch (MW::drawMode) {
 				case (D_TRI): {
 					// draw a triangle
-					Tri* tri = new Tri(MW::highlightLine.vertices.at(0), MW::highlightLine.vertices.at(1), Point2d(100, 100));
+					Tri* tri = new Tri(a, c, MW::view.toWorld(Point2d(100, 100)));
 					g = tri;
 				} break;
 				case (D_QUAD): {
 					// draw a quad
-					Point2d b = Point2d(MW::highlightLine.vertices.at(0).x, MW::highlightLine.vertices.at(1).y);
-					Point2d d = Point2d(MW::highlightLine.vertices.at(1).x, MW::highlightLine.vertices.at(0).y);
-					Quad* quad = new Quad(MW::highlightLine.vertices.at(0), b, MW::highlightLine.vertices.at(1), d);
+					Point2d b = Point2d(a.x, c.y);
+					Point2d d = Point2d(c.x, a.y);
+					Quad* quad = new Quad(a, b, c, d);
 					g = quad;
 				} break;
 				case (D_CIRCLE): {
 					// draw a circle
-					Circle* circ = new Circle(MW::highlightLine.vertices.at(0), MW::highlightLine.vertices.at(1));
+					Circle* circ = new Circle(a, c);
 					g = circ;
 				} break;
 				default: {
 					// draw a rectangle
-					Rect* rect = new Rect(MW::highlightLine.vertices.at(0), MW::highlightLine.vertices.at(1));
+					Rect* rect = new Rect(a, c);
 					g = rect;
 				}
 				}
@@ -249,11 +326,13 @@ return 0;
 static void cleanUp() {
 	MW::getRenderer()->cleanUp();
 	delete MW::getRenderer();
+	// Stopped before the queue it pushes to goes with the input
+	delete MW::syntheticInput;
 	delete MW::input;
 	for (size_t i = 0; i < MW::geometryQueue.size(); i++) {
 		delete MW::geometryQueue.at(i);
 	}
-	delete MW::qt;
+	delete MW::spatialIndex;
 	delete MW::camera;
 }
 
@@ -325,8 +404,31 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 	// Initialize renderer threads
 	MW::renderer->init(*MW::camera);
 
-	// Create base quadtree
-	MW::qt = new Quadtree(*MW::getDrawAreaPanel(Renderer::TOP_DOWN));
+	// Create the spatial index over the whole world rather than the panel it is viewed through. The command line may
+	// start with -grid or -grid=<cell size> to index with a uniform grid instead of the quadtree, and with -synthetic to
+	// drive the camera from a scripted patrol instead of the keyboard. A snapshot level brings its own index instead
+	MW::world = Rect(Point2d(0, 0), Point2d(MW::worldSize, MW::worldSize));
+	const char* levelPath = lpCmdLine ? lpCmdLine : "";
+	while (levelPath[0] == '-') {
+		if (strncmp(levelPath, "-grid", 5) == 0 && !MW::spatialIndex) {
+			uint32_t cellSize = levelPath[5] == '=' ? strtoul(levelPath + 6, nullptr, 10) : UniformGrid::DEFAULT_CELL_SIZE;
+			MW::spatialIndex = new UniformGrid(cellSize ? cellSize : UniformGrid::DEFAULT_CELL_SIZE);
+		} else if (strncmp(levelPath, "-synthetic", 10) == 0 && !MW::syntheticInput) {
+			MW::syntheticInput = new SyntheticInput(SyntheticInput::patrol(MW::syntheticHold, MW::syntheticGap), true);
+		} else {
+			break;
+		}
+		levelPath += strcspn(levelPath, " ");
+		levelPath += strspn(levelPath, " ");
+	}
+	if (!MW::spatialIndex) {
+		MW::spatialIndex = new Quadtree(MW::world);
+	}
+
+	// Level file passed on the command line
+	if (levelPath[0]) {
+		MW::importLevel(levelPath);
+	}
 
 	// Establish framerate metrics
 	const float TARGET_FRAMERATE = 60.0f;
@@ -340,6 +442,12 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 		frameUpdateFrequency = (float)performanceFrequencyMeasure.QuadPart;
 	}
 
+	// Key changes are queued with the time they arrived, from the message loop or the synthetic source, never both
+	MW::inputTime = InputQueue::now();
+	if (MW::syntheticInput) {
+		MW::syntheticInput->start(MW::input->events);
+	}
+
 	// Program loop
 	while (MW::getRunningState()) {
 		// Reset inputs
@@ -351,16 +459,25 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 			MW::conditionMouseCoords(MW::eventMessage.pt);
 			MW::currentPanel = MW::getCursorFocus((Point2d)MW::eventMessage.pt);
 
-			bool isHeld = ((MW::eventMessage.lParam & (1U << 31)) == 0);
-			MW::input->setInput(&MW::eventMessage, isHeld);
+			if (!MW::syntheticInput) {
+				bool isHeld = ((MW::eventMessage.lParam & (1U << 31)) == 0);
+				MW::input->setInput(&MW::eventMessage, isHeld);
+			}
 
 			TranslateMessage(&MW::eventMessage);
 			DispatchMessage(&MW::eventMessage);
 		}
 
-		// Perform actions for updated input_
+		// Apply every key change made since the last frame, weighted by how much of that time each key was held
+		int64_t inputEnd = InputQueue::now();
+		MW::input->consumeInput(MW::inputTime, inputEnd);
+		MW::inputTime = inputEnd;
 		MW::input->handleInput(&MW::eventMessage, dt);
 		MW::simulateFrame(dt);
+		// Copy the frame's edits for other threads, if any are reading
+		MW::publishedIndex.update(*MW::spatialIndex);
+		MW::view.setPanel(*MW::getDrawAreaPanel(Renderer::TOP_DOWN));
+		MW::view.follow(*MW::camera);
 
 		MW::renderer->clearRenderArea(MW::renderer, true);
 		// Draw highlight line for click and hold
@@ -369,19 +486,23 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 		}
 
 		// Draw camera
-		MW::renderer->updateRenderArea(*MW::camera, Renderer::TOP_DOWN, MW::camera->colour, false);
-		// Draw geometry queue from oldest to newest
-		for (int i = 0; i < MW::geometryQueue.size(); i++) {
-			MW::renderer->updateRenderArea(MW::geometryQueue[i], Renderer::TOP_DOWN);
+		MW::renderer->updateRenderArea(*MW::camera, MW::view, Renderer::TOP_DOWN, MW::camera->colour);
+		// Draw only the geometry the spatial index finds inside the view
+		MW::visibleGeometry.clear();
+		MW::spatialIndex->queryRect(MW::view.getVisibleBounds(), MW::visibleGeometry);
+		for (int i = 0; i < MW::visibleGeometry.size(); i++) {
+			MW::renderer->updateRenderArea(MW::visibleGeometry[i], MW::view, Renderer::TOP_DOWN);
 		}
-		// Draw quadtree grid
-		std::vector<Line*>* grid = MW::qt->getQuadtreeGrid();
-		for (int i = 0; i < grid->size(); i++) {
-			MW::getRenderer()->updateRenderArea(grid->at(i), Renderer::TOP_DOWN, 0xff0000, true);
+		// Draw the index's grid
+		const SpatialIndex::Grid& grid = MW::spatialIndex->getGrid();
+		MW::getRenderer()->updateRenderArea(grid.horizontal, Renderer::HORIZONTAL, MW::view, Renderer::TOP_DOWN, 0xff0000);
+		MW::getRenderer()->updateRenderArea(grid.vertical, Renderer::VERTICAL, MW::view, Renderer::TOP_DOWN, 0xff0000);
+
+		// Draw first person walls, visited front to back only until every column has one
+		if (MW::bspStale) {
+			MW::rebuildBsp();
 		}
-
-		// Pass geometry queue and camera to the renderer to determine how to update the buffer
-		MW::renderer->updateRenderArea(MW::geometryQueue, *MW::camera);
+		MW::renderer->updateRenderArea(MW::bsp, *MW::camera);
 
 		// Draw updated RenderArea to screen
 		MW::renderer->drawRenderArea(hdc);
@@ -395,6 +516,12 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 		dbg.setMsg(&MW::eventMessage);
 		dbg.setFps(dt);
 		Debug::Print(&dbg);
+		// Report how much narrow phase collision work the cached bounds avoided this frame
+		Debug::DebugMessage broadPhaseDbg(MAIN_WINDOW_CLASS, BROAD_PHASE_STATS);
+		broadPhaseDbg.setMsg(&MW::eventMessage);
+		broadPhaseDbg.setOutputString(BroadPhase::toString());
+		Debug::Print(&broadPhaseDbg);
+		BroadPhase::reset();
 		frameBeginTime = frameEndTime;
 	}
 
@@ -450,13 +577,84 @@ int MainWindow::getCursorFocus(Point2d p) {
 void MainWindow::addGeometry(Geometry* g) {
 
 	MW::geometryQueue.push_back(g);
-	MW::qt->addGeometry(g);
+	MW::spatialIndex->addGeometry(g);
+	MW::bspStale = true;
+	MW::publishedIndex.invalidate();
+}
+
+void MainWindow::addGeometry(const std::vector<Geometry*>& geometry) {
+
+	MW::geometryQueue.insert(MW::geometryQueue.end(), geometry.begin(), geometry.end());
+	MW::spatialIndex->addGeometry(geometry);
+	MW::bspStale = true;
+	MW::publishedIndex.invalidate();
+}
+
+bool MainWindow::importLevel(const char* path) {
+
+	bool result;
+	size_t count;
+	if (Snapshot::isSnapshot(path)) {
+		// The snapshot's prebuilt grid replaces the index, answering queries straight from the mapped file. Shapes are
+		// only built from their records once a query reports them, so nothing is read for parts of the scene never seen
+		result = MW::snapshot.open(path);
+		count = MW::snapshot.getShapeCount();
+		if (result) {
+			SnapshotIndex* index = new SnapshotIndex(MW::snapshot);
+			index->addGeometry(MW::geometryQueue);
+			delete MW::spatialIndex;
+			MW::spatialIndex = index;
+			MW::bspStale = true;
+			MW::publishedIndex.invalidate();
+		}
+	} else {
+		std::vector<Geometry*> loaded;
+		result = Level::load(path, loaded);
+		count = loaded.size();
+		MW::addGeometry(loaded);
+	}
+
+	Debug::DebugMessage dbg(MAIN_WINDOW_CLASS, LEVEL_IMPORT);
+	dbg.setOutputString(std::string(result ? "loaded " : "failed after ") + std::to_string(count) + " shapes\n");
+	Debug::Print(&dbg);
+	return result;
+}
+
+bool MainWindow::saveSnapshot(const char* path) {
+
+	std::vector<Geometry*> scene;
+	MW::getScene(scene);
+	bool result = Snapshot::write(path, scene);
+
+	Debug::DebugMessage dbg(MAIN_WINDOW_CLASS, LEVEL_IMPORT);
+	dbg.setOutputString(std::string(result ? "snapshot of " : "failed to snapshot ") + std::to_string(scene.size()) + " shapes to " + path + "\n");
+	Debug::Print(&dbg);
+	return result;
 }
 
 void MainWindow::removeGeometry(Geometry* g) {
 
 	MW::geometryQueue.pop_back();
-	MW::qt->removeGeometry(g);
+	MW::spatialIndex->removeGeometry(g);
+	MW::bspStale = true;
+	MW::publishedIndex.invalidate();
+}
+
+void MainWindow::getScene(std::vector<Geometry*>& scene) {
+
+	if (MW::spatialIndex->getType() == SpatialIndex::SNAPSHOT) {
+		static_cast<SnapshotIndex*>(MW::spatialIndex)->getSnapshotShapes(scene);
+	}
+	scene.insert(scene.end(), MW::geometryQueue.begin(), MW::geometryQueue.end());
+}
+
+void MainWindow::rebuildBsp() {
+
+	// Every snapshot shape is built for this on the first frame, as the BSP has to hold every wall to order them
+	std::vector<Geometry*> scene;
+	MW::getScene(scene);
+	MW::bsp.build(scene);
+	MW::bspStale = false;
 }
 
 void MainWindow::simulateFrame(float dt) {
@@ -481,62 +679,33 @@ void MainWindow::simulateFrame(float dt) {
 	// Incremental change in direction
 	double dTheta = MW::camera->va * dt;
 
-	bool collision = false;
-	Point2d center = Point2d(MW::camera->x, MW::camera->y);
-	Line xAxis = Line(Point2d(0, 0), Point2d(1, 0));
-	for (int i = 0; i < MW::geometryQueue.size(); i++) {
-		std::map<Point2d, std::vector<Line>> collisions;
-		MW::camera->checkCollisionWith(geometryQueue[i], collisions);
-
-		if (!collisions.empty()) {
-			collision = true;
-			// Determine normal of each collision and adjust position of camera to remove collision
-			int count = 0;
-			for (auto pair : collisions) {
-				count++;
-				Point2d c = pair.first;
-				Line normal = Line(c, center);
-				for (auto side : pair.second) {
-					Line testLine = Line(side.vertices.at(1), side.vertices.at(0));
-					if (abs(normal.calculateAngle(side) * 180 / M_PI - 90) > 3) {
-						continue;
-					}
-
-					double angleOfXAxisToSide = xAxis.calculateAngle(side);
-					double alpha = angleOfXAxisToSide > 90 ? (180 - angleOfXAxisToSide) : angleOfXAxisToSide;
-					// Calculate magnitude of current change in position (analogous to speed)
-					double totalVelocity = sqrt(dPx * dPx + dPy * dPy);
-					double angleOfMotionToSide = acos((dPx * side.getDx() + dPy * side.getDy()) / (totalVelocity * side.calculateLength()));
-					double gamma = angleOfMotionToSide > 90 ? (180 - angleOfMotionToSide) : angleOfMotionToSide;
-					// Calculate the new velocity produced by sliding along the side of the geometry
-					double newVelocity = totalVelocity * cos(gamma);
-
-					// Calculate the x and y components of that 'velocity'
-					if (normal.getDx() * MW::camera->ax < 0) {
-						dPx = newVelocity * cos(alpha);
-					}
-					if (normal.getDy() *MW::camera->ay < 0) {
-						dPy = newVelocity * sin(alpha);
-					}
-				}
-			}
-		}
+	// Only shapes within the camera's reach plus this frame's motion can be touched or swept into
+	MW::nearbyGeometry.clear();
+	uint32_t reach = MW::camera->size / 2 + (uint32_t)ceil(sqrt(dPx * dPx + dPy * dPy)) + 1;
+	MW::spatialIndex->queryCircle(Point2d(MW::camera->x, MW::camera->y), reach, MW::nearbyGeometry);
+
+	// Gather contacts against those shapes into the one manifold, reused across frames
+	MW::contacts.clear();
+	for (int i = 0; i < MW::nearbyGeometry.size(); i++) {
+		MW::camera->checkCollisionWith(MW::nearbyGeometry[i], MW::contacts);
 	}
+
+	bool collision = !MW::contacts.empty();
+	// Slide along every side the camera is pushing into
+	MW::contacts.resolveDisplacement(dPx, dPy);
 	if (collision) {
 		MW::camera->colour = 0xff0000;
 	} else {
 		MW::camera->colour = 0xffffff;
 	}
 
-	// p = p + v*t + 1/2*a*t^2
-	MW::camera->px = MW::camera->px + dPx;
-	MW::camera->py = MW::camera->py + dPy;
+	// p = p + v*t + 1/2*a*t^2, swept against the scene so thin sides cannot be skipped over
+	MW::moveCamera(dPx, dPy);
 	MW::camera->x = (uint32_t)(MW::camera->px + 0.5);
 	MW::camera->y = (uint32_t)(MW::camera->py + 0.5);
-	MW::camera->clampPosition(*MW::getDrawAreaPanel(Renderer::TOP_DOWN));
+	MW::camera->clampPosition(MW::world);
 
-	MW::camera->direction = MW::camera->direction + dTheta;
-	MW::camera->clampDirection();
+	MW::camera->direction += BinaryAngle::fromDegrees(dTheta);
 
 	MW::camera->update();
 
@@ -546,6 +715,46 @@ void MainWindow::simulateFrame(float dt) {
 	dbg.Print();
 }
 
+// Advance the camera to its first time of impact along the motion, then slide along the contact for the time remaining.
+// Sweeps only the shapes simulateFrame found within reach, which the remaining motion can never leave
+void MainWindow::moveCamera(double dPx, double dPy) {
+
+	for (int i = 0; i < MW::maxSweeps && (dPx != 0 || dPy != 0); i++) {
+		double toi = 1.0;
+		Contact first;
+		bool hit = false;
+		for (int j = 0; j < MW::nearbyGeometry.size(); j++) {
+			hit = MW::camera->sweep(MW::nearbyGeometry[j], dPx, dPy, toi, first) || hit;
+		}
+		if (!hit) {
+			MW::camera->px += dPx;
+			MW::camera->py += dPy;
+			return;
+		}
+
+		// Stop just short of the contact so the next sweep does not start inside it
+		double length = sqrt(dPx * dPx + dPy * dPy);
+		double skin = length > 0 ? 0.01 / length : 0;
+		double t = toi > skin ? toi - skin : 0;
+		MW::camera->px += dPx * t;
+		MW::camera->py += dPy * t;
+
+		// Remove the component of the remaining motion, and of the velocity, that points into the contact
+		dPx *= 1.0 - t;
+		dPy *= 1.0 - t;
+		double into = dPx * first.nx + dPy * first.ny;
+		if (into < 0) {
+			dPx -= into * first.nx;
+			dPy -= into * first.ny;
+		}
+		double velocityInto = MW::camera->vx * first.nx + MW::camera->vy * first.ny;
+		if (velocityInto < 0) {
+			MW::camera->vx -= velocityInto * first.nx;
+			MW::camera->vy -= velocityInto * first.ny;
+		}
+	}
+}
+
 // Find the appropriate memory address that reflects the lower left point of the geometry object
 void* MainWindow::findMemoryHandle(Geometry* g) {
 
@@ -656,13 +865,21 @@ void MainWindow::drawHighlightLine() {
 		MW::highlightLine.checkCollisionWith(rect, collisions, sides);
 	}
 
+	// Geometry and camera live in the world, so test the line there and bring the hits back to the screen
+	Line worldLine(MW::view.toWorld(MW::geoStart), MW::view.toWorld(end));
+	std::vector<Point2d> worldCollisions;
 	std::vector<Line> interferingSides;
-	// Check for collisions against current geometry
-	for (int i = 0; i < MW::geometryQueue.size(); i++) {
-		MW::highlightLine.checkCollisionWith(MW::geometryQueue[i], collisions, interferingSides);
+	// Check for collisions against the geometry the line passes over
+	std::vector<Geometry*> crossed;
+	MW::spatialIndex->querySegment(worldLine.vertices.at(0), worldLine.vertices.at(1), crossed);
+	for (int i = 0; i < crossed.size(); i++) {
+		Collision::test(&worldLine, crossed[i], worldCollisions, interferingSides);
 	}
 	// Check for collisions against camera
-	MW::highlightLine.checkCollisionWith(MW::camera, collisions, sides);
+	worldLine.checkCollisionWith(MW::camera, worldCollisions, sides);
+	for (const Point2d& p : worldCollisions) {
+		collisions.push_back(MW::view.toView(p));
+	}
 
 	int colour = 0xff00;
 	if (!collisions.empty()) {
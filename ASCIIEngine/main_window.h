@@ -5,9 +5,15 @@
 #include <windowsx.h>
 #include <stdint.h>
 #include <vector>
+#include "bsp_tree.h"
 #include "geometry.h"
 #include "input.h"
+#include "published_index.h"
 #include "quadtree.h"
+#include "snapshot.h"
+#include "snapshot_index.h"
+#include "uniform_grid.h"
+#include "viewport.h"
 
 // shorten name, make it easier to use
 #define MW MainWindow
@@ -46,8 +52,24 @@ namespace MainWindow {
 	Point2d geoStart, geoEnd;
 	Line highlightLine;
 	Camera* camera;
+	const uint32_t worldSize = 1 << 16;
+	Rect world; // Extent of the quadtree and of camera movement, independent of the window size
+	Viewport view; // TOP_DOWN world to screen transform, following the camera
+	const int32_t panStep = 40; // Screen pixels moved per arrow key press
+	std::vector<Geometry*> visibleGeometry; // Shapes overlapping the view, gathered once per frame
+	std::vector<Geometry*> nearbyGeometry; // Shapes the camera can reach this frame
+	ContactManifold contacts; // Reused every frame by simulateFrame
+	const uint8_t maxSweeps = 4; // Contacts resolved per frame by moveCamera before any remaining motion is dropped
 	std::vector<Geometry*> geometryQueue;
-	Quadtree* qt;
+	Snapshot::View snapshot; // Scene the engine started from, kept mapped for the session
+	SpatialIndex* spatialIndex = nullptr; // Quadtree, a uniform grid when started with -grid, or the snapshot's own index
+	BspTree bsp; // Walls of the whole scene ordered for the first person pass, rebuilt after edits
+	bool bspStale = true;
+	int64_t inputTime; // End of the interval of input the simulation has consumed, on InputQueue::now's clock
+	SyntheticInput* syntheticInput = nullptr; // Drives the camera in place of the keyboard when started with -synthetic
+	const int64_t syntheticHold = 750000000; // Nanoseconds each patrol key is held
+	const int64_t syntheticGap = 250000000; // Nanoseconds between patrol keys
+	PublishedIndex publishedIndex; // Copies of spatialIndex for threads other than this one to query, published once a frame after edits
 
 	MSG eventMessage;
 
@@ -60,8 +82,15 @@ namespace MainWindow {
 	int getCursorFocus(Point2d p);
 
 	void addGeometry(Geometry* g);
+	void addGeometry(const std::vector<Geometry*>& geometry);
+	bool importLevel(const char* path);
+	bool saveSnapshot(const char* path);
 	void removeGeometry(Geometry* g);
+	// Shapes still in the snapshot the engine started from, building any not yet built, then those drawn since
+	void getScene(std::vector<Geometry*>& scene);
+	void rebuildBsp();
 	void simulateFrame(float secondsPerFrame);
+	void moveCamera(double dPx, double dPy);
 
 	void* findMemoryHandle(Geometry* g);
 
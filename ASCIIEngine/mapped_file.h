@@ -0,0 +1,31 @@
+#ifndef ASCIIENGINE_MAPPED_FILE_H_
+#define ASCIIENGINE_MAPPED_FILE_H_
+
+#include <Windows.h>
+#include <stdint.h>
+
+// Read only view of a whole file, mapped into the address space so the OS pages it in as it is read
+class MappedFile {
+
+public:
+	MappedFile() {};
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator = (const MappedFile&) = delete;
+	~MappedFile() { close(); };
+
+	bool open(const char* path);
+	void close();
+
+	bool isOpen() const { return data != nullptr; };
+	const uint8_t* begin() const { return data; };
+	const uint8_t* end() const { return data + size; };
+	uint64_t getSize() const { return size; };
+
+private:
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+	const uint8_t* data = nullptr;
+	uint64_t size = 0;
+};
+
+#endif
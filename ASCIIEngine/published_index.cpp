@@ -0,0 +1,82 @@
+#include "published_index.h"
+
+PublishedIndex::Pin::Pin(PublishedIndex& p_index, int p_slot) : index(p_index), slot(p_slot) {
+	// Announce the epoch before loading the copy. A writer that has not yet seen the announcement has already made a
+	// newer copy current, so this load cannot return anything it is about to free
+	index.readerEpochs[slot].store(index.epoch.load());
+	copy = index.current.load();
+}
+
+PublishedIndex::Pin::~Pin() {
+	index.readerEpochs[slot].store(IDLE);
+}
+
+PublishedIndex::~PublishedIndex() {
+	delete current.load();
+	for (const Retired& r : retired) {
+		delete r.copy;
+	}
+}
+
+int PublishedIndex::acquireSlot() {
+	for (int i = 0; i < MAX_READERS; i++) {
+		bool expected = false;
+		if (claimed[i].compare_exchange_strong(expected, true)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+void PublishedIndex::releaseSlot(int slot) {
+	readerEpochs[slot].store(IDLE);
+	claimed[slot].store(false);
+}
+
+bool PublishedIndex::hasReaders() const {
+	for (int i = 0; i < MAX_READERS; i++) {
+		if (claimed[i].load()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool PublishedIndex::update(const SpatialIndex& index) {
+	if (stale && hasReaders()) {
+		publish(index);
+		return true;
+	}
+	reclaim();
+	return false;
+}
+
+void PublishedIndex::publish(const SpatialIndex& index) {
+	stale = false;
+	const SpatialIndex* previous = current.exchange(index.clone());
+	// Readers announcing after this increment load the new copy, so the previous one is only reachable from earlier epochs
+	uint64_t retiredAt = epoch.fetch_add(1);
+	if (previous) {
+		retired.push_back({ previous, retiredAt });
+	}
+	reclaim();
+}
+
+void PublishedIndex::reclaim() {
+	uint64_t oldest = UINT64_MAX;
+	for (int i = 0; i < MAX_READERS; i++) {
+		uint64_t e = readerEpochs[i].load();
+		if (e != IDLE) {
+			oldest = min(oldest, e);
+		}
+	}
+	size_t kept = 0;
+	for (const Retired& r : retired) {
+		if (r.epoch < oldest) {
+			delete r.copy;
+		} else {
+			retired[kept++] = r;
+		}
+	}
+	retired.resize(kept);
+}
@@ -0,0 +1,74 @@
+#ifndef ASCIIENGINE_PUBLISHED_INDEX_H_
+#define ASCIIENGINE_PUBLISHED_INDEX_H_
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+#include "spatial_index.h"
+
+// Read access to the spatial index for threads other than the one editing it. The writer keeps editing its own index and
+// publishes immutable copies of it; readers pin whichever copy is current for as long as their queries take. Readers
+// never lock and never see an index mid edit, and a copy is only freed once no reader can still hold it (epoch based
+// reclamation). The shapes are shared with the writer's index rather than copied, so must outlive any copy naming them.
+// Copying is the whole index, so the writer marks edits and copies at most once a frame, and only while a reader exists
+class PublishedIndex {
+
+public:
+	static const int MAX_READERS = 8;
+
+	// A pinned copy, held while in scope. Only one per reader slot at a time
+	class Pin {
+	public:
+		Pin(PublishedIndex& p_index, int p_slot);
+		~Pin();
+		Pin(const Pin&) = delete;
+		Pin& operator = (const Pin&) = delete;
+
+		const SpatialIndex* get() const { return copy; }; // nullptr until the first publish
+		const SpatialIndex* operator -> () const { return copy; };
+
+	private:
+		PublishedIndex& index;
+		int slot;
+		const SpatialIndex* copy;
+	};
+
+	PublishedIndex() {};
+	~PublishedIndex(); // No reader may still be pinned
+	PublishedIndex(const PublishedIndex&) = delete;
+	PublishedIndex& operator = (const PublishedIndex&) = delete;
+
+	// Reader threads claim a slot once and pin through it, returning -1 when all are taken. A newly claimed slot sees
+	// the writer's edits from its next update on
+	int acquireSlot();
+	void releaseSlot(int slot);
+	bool hasReaders() const;
+
+	// Writer only. The index has been edited since it was last published
+	void invalidate() { stale = true; };
+	// Writer only, once a frame. Publishes if the index has been edited and a reader holds a slot, otherwise only
+	// reclaims. Returns whether it published
+	bool update(const SpatialIndex& index);
+	// Writer only. Copies the index, makes the copy current, and frees any retired copy no reader can still be using
+	void publish(const SpatialIndex& index);
+	void reclaim();
+	uint64_t getEpoch() const { return epoch.load(); };
+	size_t getRetiredCount() const { return retired.size(); };
+
+private:
+	static const uint64_t IDLE = 0;
+
+	struct Retired {
+		const SpatialIndex* copy;
+		uint64_t epoch; // Last epoch in which a reader could have pinned it
+	};
+
+	std::atomic<const SpatialIndex*> current{ nullptr };
+	std::atomic<uint64_t> epoch{ 1 };
+	std::atomic<uint64_t> readerEpochs[MAX_READERS] = {}; // Epoch each reader pinned at, or IDLE
+	std::atomic<bool> claimed[MAX_READERS] = {};
+	std::vector<Retired> retired; // Writer only
+	bool stale = true; // Writer only
+};
+
+#endif
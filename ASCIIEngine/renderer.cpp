@@ -1,5 +1,6 @@
 #include "renderer.h"
 #include "character_set.h"
+#include <algorithm>
 #include <iostream>
 
 Renderer::Renderer(Rect* drawRect, uint8_t borderWidth) {
@@ -187,6 +188,14 @@ void Renderer::updateRenderArea(Geometry* g, int panel, uint32_t colour, bool va
 		updateRenderArea(l2, panel, colour, valid);
 		//UpdateRenderArea(static_cast<Tri>(g), 0);
 	} break;
+	case Geometry::G_QUAD:
+	case Geometry::G_POLYGON:
+	{
+		for (int i = 0; i < g->vertices.size(); i++) {
+			Line l = Line(g->vertices.at(i), g->vertices.at(i + 1 == g->vertices.size() ? 0 : i + 1));
+			updateRenderArea(l, panel, colour, valid);
+		}
+	} break;
 	case Geometry::G_RECT:
 	{
 		updateRenderArea(static_cast<Rect>(*g), 0);
@@ -341,6 +350,104 @@ void Renderer::updateRenderArea(const Circle& circle, int panel, uint32_t colour
 	}
 }
 
+void Renderer::updateRenderArea(Geometry* g, const Viewport& view, int panel, uint32_t colour) {
+	switch (g->type) {
+	case Geometry::G_LINE:
+	{
+		updateRenderArea(g->vertices.at(0), g->vertices.at(1), view, panel, colour);
+	} break;
+	case Geometry::G_TRI:
+	case Geometry::G_QUAD:
+	case Geometry::G_POLYGON:
+	{
+		for (int i = 0; i < g->vertices.size(); i++) {
+			updateRenderArea(g->vertices.at(i), g->vertices.at(i + 1 == g->vertices.size() ? 0 : i + 1), view, panel, colour);
+		}
+	} break;
+	case Geometry::G_RECT:
+	{
+		// Filled, so only the part inside the view is transformed and drawn
+		BoundingBox visible = view.getVisibleBounds();
+		BoundingBox clipped(max(g->bounds.minX, visible.minX), max(g->bounds.minY, visible.minY), min(g->bounds.maxX, visible.maxX), min(g->bounds.maxY, visible.maxY));
+		if (clipped.isEmpty()) {
+			return;
+		}
+		updateRenderArea(Rect(view.toView(clipped.minX, clipped.minY), view.toView(clipped.maxX, clipped.maxY)), panel);
+	} break;
+	case Geometry::G_CIRCLE:
+	{
+		BoundingBox visible = view.getVisibleBounds();
+		for (const Point2d& v : g->vertices) {
+			if (visible.contains(v)) {
+				updateRenderArea(view.toView(v), panel, 0xAAAAAA);
+			}
+		}
+	} break;
+	}
+}
+
+void Renderer::updateRenderArea(const Point2d& a, const Point2d& b, const Viewport& view, int panel, uint32_t colour) {
+	double ax = a.x, ay = a.y, bx = b.x, by = b.y;
+	if (!view.clip(ax, ay, bx, by)) {
+		return;
+	}
+	updateRenderArea(Line(view.toView(ax, ay), view.toView(bx, by)), panel, colour);
+}
+
+void Renderer::updateRenderArea(const Camera& c, const Viewport& view, int panel, uint32_t colour) {
+	updateRenderArea(c.base, c.tip, view, panel, colour);
+	updateRenderArea(c.tip, c.left, view, panel, colour);
+	updateRenderArea(c.tip, c.right, view, panel, colour);
+}
+
+void Renderer::updateRenderArea(const std::vector<Span>& spans, Dimension d, const Viewport& view, int panel, uint32_t colour) {
+	BoundingBox visible = view.getVisibleBounds();
+	if (visible.isEmpty()) {
+		return;
+	}
+	const Rect& area = drawArea.panels[panel];
+	for (const Span& s : spans) {
+		// Cull and trim in world space, then clamp the transformed ends to the panel
+		Point2d first, last;
+		if (d == HORIZONTAL) {
+			if (s.at < visible.minY || s.at > visible.maxY || s.to < visible.minX || s.from > visible.maxX) {
+				continue;
+			}
+			first = view.toView(max(s.from, visible.minX), s.at);
+			last = view.toView(min(s.to, visible.maxX), s.at);
+			if (first.y < area.lt.y || first.y > area.rb.y) {
+				continue;
+			}
+			first.x = max(first.x, area.lt.x);
+			last.x = min(last.x, area.rb.x);
+		} else {
+			if (s.at < visible.minX || s.at > visible.maxX || s.to < visible.minY || s.from > visible.maxY) {
+				continue;
+			}
+			first = view.toView(s.at, max(s.from, visible.minY));
+			last = view.toView(s.at, min(s.to, visible.maxY));
+			if (first.x < area.lt.x || first.x > area.rb.x) {
+				continue;
+			}
+			first.y = max(first.y, area.lt.y);
+			last.y = min(last.y, area.rb.y);
+		}
+
+		// Rows are contiguous in memory, and a column steps back one row per pixel as y increases
+		uint32_t* pixel = (uint32_t*)getMemoryLocation(panel, first);
+		if (d == HORIZONTAL) {
+			if (first.x <= last.x) {
+				std::fill_n(pixel, last.x - first.x + 1, colour);
+			}
+		} else {
+			for (uint32_t y = first.y; y <= last.y; y++, pixel -= drawArea.width) {
+				*pixel = colour;
+			}
+		}
+	}
+	drawArea.update = true;
+}
+
 void Renderer::drawRenderArea(HDC hdc) {
 	if (!drawArea.update)
 		return;
@@ -544,10 +651,8 @@ uint16_t Renderer::validate(const Rect& rect, uint32_t bounds[], int panel) {
 uint16_t Renderer::validate(const Circle& c, uint32_t bounds[], int panel) {
 	uint16_t result = 0b0;
 
-	result |= validate(Point2d(c.center.x - c.r, c.center.y), bounds, panel) << 0; // left
-	result |= validate(Point2d(c.center.x + c.r, c.center.y), bounds, panel) << 4; // right
-	result |= validate(Point2d(c.center.x, c.center.y - c.r), bounds, panel) << 8; // top
-	result |= validate(Point2d(c.center.x, c.center.y + c.r), bounds, panel) << 12; // bottom
+	result |= validate(Point2d(c.bounds.minX, c.bounds.minY), bounds, panel) << 0; // left and top
+	result |= validate(Point2d(c.bounds.maxX, c.bounds.maxY), bounds, panel) << 4; // right and bottom
 
 	return result;
 }
@@ -629,10 +734,7 @@ Rect Renderer::clipRect(const Rect & r, const uint32_t bounds[], const uint16_t
 	return Rect(Point2d(dimensions[0], dimensions[1]), Point2d(dimensions[2], dimensions[3]));
 }
 
-void Renderer::updateRenderArea(const std::vector<Geometry*>& geometry, const Camera& camera) {
-	int horizontalCount = drawArea.panels[FIRST_PERSON].getWidth() / TILE_WIDTH;
-	int verticalCount = drawArea.panels[FIRST_PERSON].getHeight() / TILE_HEIGHT;
-
+void Renderer::updateRenderArea(const BspTree& bsp, const Camera& camera) {
 	// Use a thread to render the right hand panel and swap buffers as appropriate
 	for (int i = 0; i < THREAD_COUNT; i++) {
 		if (threadPool[FIRST_PERSON][i].joinable()) {
@@ -641,9 +743,33 @@ void Renderer::updateRenderArea(const std::vector<Geometry*>& geometry, const Ca
 			//break;
 		}
 	}
+	coverage.reset(getFirstPersonColumns());
+	bsp.castColumns(camera, coverage, wallColumns);
+	updateRenderArea(wallColumns);
+}
+
+void Renderer::updateRenderArea(const std::vector<WallColumn>& columns) {
+	Rect& panel = drawArea.panels[FIRST_PERSON];
+	int verticalCount = panel.getHeight() / TILE_HEIGHT;
+	for (size_t i = 0; i < columns.size(); i++) {
+		if (!columns[i].g) {
+			continue;
+		}
+		// Rows above and below the horizon, and one glyph for the whole column
+		int half = (int)min((double)verticalCount / 2, verticalCount * WALL_SCALE / columns[i].distance / 2);
+		float brightness = (float)max(0.0, 1 - columns[i].distance / WALL_FADE);
+		std::vector<uint8_t> character = getCharacterBitmap(brightness);
+		for (int j = verticalCount / 2 - half; j < verticalCount / 2 + half; j++) {
+			updateRenderArea(character, panel.lt.x + TILE_WIDTH * (uint32_t)i, panel.lt.y + TILE_HEIGHT * j, 0);
+		}
+	}
 	drawArea.update = true;
 }
 
+uint32_t Renderer::getFirstPersonColumns() {
+	return drawArea.panels[FIRST_PERSON].getWidth() / TILE_WIDTH;
+}
+
 void Renderer::updateRenderArea(Renderer* instance, const Camera& camera, const int& bufferId) {
 	int horizontalCount = instance->drawArea.panels[FIRST_PERSON].getWidth() / TILE_WIDTH;
 	int verticalCount = instance->drawArea.panels[FIRST_PERSON].getHeight() / TILE_HEIGHT;
@@ -651,7 +777,7 @@ void Renderer::updateRenderArea(Renderer* instance, const Camera& camera, const
 	float xCoeff, yCoeff, brightnessCoeff;
 	for (float j = 0; j < verticalCount; j++) {
 		for (float i = 0; i < horizontalCount; i++) {
-			//ray = Ray3d(camera.x, camera.y, camera.height, camera.direction, 0);
+			//ray = Ray3d(camera.x, camera.y, camera.height, camera.direction, BinaryAngle());
 			xCoeff = abs(i - horizontalCount / 2) / horizontalCount;
 			yCoeff = abs(j - verticalCount / 2) / verticalCount;
 			brightnessCoeff = sqrt((xCoeff * xCoeff + yCoeff * yCoeff) / 2);
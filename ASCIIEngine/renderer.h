@@ -5,7 +5,9 @@
 #include <Windows.h>
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include "bsp_tree.h"
 #include "geometry.h"
+#include "viewport.h"
 #include "debug.h"
 #include <thread>
 
@@ -68,6 +70,8 @@ public:
 	const uint32_t colours[3][2] = { { 0x0, 0x111111}, { 0x0, 0x111133 }, { 0x444444, 0x444444 } };
 
 	static const int PANEL_COUNT = 2;
+	static constexpr double WALL_SCALE = 64; // Distance at which a wall fills the first person panel's height
+	static constexpr double WALL_FADE = 4096; // Distance at which a wall has faded to the sparsest character
 	static const int THREAD_COUNT = 1;
 	std::thread threadPool[PANEL_COUNT][THREAD_COUNT];
 	//std::thread bacThread = std::thread() // bac = background and clear thread
@@ -81,7 +85,11 @@ public:
 	uint16_t validate(Geometry* g, uint32_t bounds[], int panel = -1);
 	Line clipLine(const Line& l, const uint32_t bounds[], const uint16_t& clipType, int panel);
 	Rect clipRect(const Rect& r, const uint32_t bounds[], const uint16_t& clipType, int panel);
-	void updateRenderArea(const std::vector<Geometry*>& geometry, const Camera& camera);
+	// First person walls of the scene, cast front to back through bsp only until every column is covered
+	void updateRenderArea(const BspTree& bsp, const Camera& camera);
+	// First person walls, a column of tiles per entry, taller and denser the nearer the wall
+	void updateRenderArea(const std::vector<WallColumn>& columns);
+	uint32_t getFirstPersonColumns();
 	void updateRenderArea(std::vector<uint8_t> character, uint32_t x, uint32_t y, const int& bufferId);
 	void updateRenderArea(const Point2d& p, int panel, uint32_t colour = 0xFF0000, bool valid = false);
 	void updateRenderArea(const Camera& c, int panel, uint32_t colour = 0xFFFFFF, bool valid = false);
@@ -92,6 +100,12 @@ public:
 	void updateRenderArea(const Tri& t, int panel, uint32_t colour = 0x555555, bool valid = false);
 	void updateRenderArea(const Rect& r, int panel, uint32_t colour = 0x333333, bool valid = false);
 	void updateRenderArea(const Circle& c, int panel, uint32_t colour = 0xAAAAAA, bool valid = false);
+	// World space drawing through a viewport, clipped to its visible bounds before being transformed
+	void updateRenderArea(Geometry* g, const Viewport& view, int panel, uint32_t colour = 0xFFFFFF);
+	void updateRenderArea(const Point2d& a, const Point2d& b, const Viewport& view, int panel, uint32_t colour = 0x777777);
+	void updateRenderArea(const Camera& c, const Viewport& view, int panel, uint32_t colour = 0xFFFFFF);
+	// Axis aligned spans filled directly as rows or columns of the buffer, with no line rasterization
+	void updateRenderArea(const std::vector<Span>& spans, Dimension d, const Viewport& view, int panel, uint32_t colour);
 	void drawRenderArea(HDC hdc);
 	static void clearRenderArea(Renderer* renderer, const bool& force = false, const int& panel = -1, const uint32_t& colour = UINT32_MAX);
 	static void updateRenderArea(Renderer* renderer, const Camera& camera, const int& bufferId);
@@ -112,6 +126,8 @@ public:
 
 private:
 	DrawArea drawArea;
+	ColumnCoverage coverage; // Reused by the first person pass
+	std::vector<WallColumn> wallColumns;
 
 	std::vector<uint8_t> getCharacterBitmap(char c);
 
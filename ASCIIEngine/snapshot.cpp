@@ -0,0 +1,261 @@
+#include "snapshot.h"
+#include <cstring>
+#include "level.h"
+
+// Anonymous namespace to hide internal helper functions
+namespace {
+	uint64_t align(uint64_t offset) {
+		return (offset + 7) & ~(uint64_t)7;
+	}
+
+	template <typename T>
+	void appendSection(std::vector<uint8_t>& buffer, uint64_t offset, const T* data, size_t count) {
+		buffer.resize(offset + count * sizeof(T));
+		if (count) {
+			memcpy(buffer.data() + offset, data, count * sizeof(T));
+		}
+	}
+}
+
+bool Snapshot::write(const char* path, const std::vector<Geometry*>& geometry, uint32_t cellSize) {
+	Header header = {};
+	header.magic = MAGIC;
+	header.version = VERSION;
+	header.headerSize = sizeof(Header);
+	header.shapeCount = (uint32_t)geometry.size();
+
+	// Shape records and their values, as the level format stores them
+	std::vector<ShapeRecord> shapes(geometry.size());
+	std::vector<uint32_t> values;
+	BoundingBox scene;
+	for (size_t i = 0; i < geometry.size(); i++) {
+		Geometry* g = geometry[i];
+		ShapeRecord& s = shapes[i];
+		s.type = (uint8_t)g->type;
+		s.reserved = 0;
+		s.firstValue = (uint32_t)values.size();
+		if (!Level::writeValues(g, values)) {
+			return false;
+		}
+		s.valueCount = (uint16_t)(values.size() - s.firstValue);
+		s.minX = g->bounds.minX; s.minY = g->bounds.minY;
+		s.maxX = g->bounds.maxX; s.maxY = g->bounds.maxY;
+		scene.include(Point2d(s.minX, s.minY));
+		scene.include(Point2d(s.maxX, s.maxY));
+	}
+	header.valueCount = (uint32_t)values.size();
+
+	// Grid over the scene bounds, coarsened until the cell count fits
+	if (scene.isEmpty()) {
+		scene = BoundingBox(0, 0, 0, 0);
+	}
+	cellSize = cellSize ? cellSize : DEFAULT_CELL_SIZE;
+	uint64_t columns, rows;
+	while (true) {
+		columns = (uint64_t)(scene.maxX - scene.minX) / cellSize + 1;
+		rows = (uint64_t)(scene.maxY - scene.minY) / cellSize + 1;
+		if (columns * rows <= MAX_CELLS) {
+			break;
+		}
+		cellSize *= 2;
+	}
+	header.originX = scene.minX;
+	header.originY = scene.minY;
+	header.cellSize = cellSize;
+	header.columns = (uint32_t)columns;
+	header.rows = (uint32_t)rows;
+
+	// Counting sort of shapes into cells: count, prefix sum, then fill
+	std::vector<uint32_t> cellStarts(columns * rows + 1, 0);
+	for (const ShapeRecord& s : shapes) {
+		for (uint32_t y = (s.minY - scene.minY) / cellSize; y <= (s.maxY - scene.minY) / cellSize; y++) {
+			for (uint32_t x = (s.minX - scene.minX) / cellSize; x <= (s.maxX - scene.minX) / cellSize; x++) {
+				cellStarts[y * columns + x + 1]++;
+			}
+		}
+	}
+	for (size_t i = 1; i < cellStarts.size(); i++) {
+		cellStarts[i] += cellStarts[i - 1];
+	}
+	std::vector<uint32_t> cellItems(cellStarts.back());
+	std::vector<uint32_t> cursor(cellStarts.begin(), cellStarts.end() - 1);
+	for (uint32_t i = 0; i < shapes.size(); i++) {
+		const ShapeRecord& s = shapes[i];
+		for (uint32_t y = (s.minY - scene.minY) / cellSize; y <= (s.maxY - scene.minY) / cellSize; y++) {
+			for (uint32_t x = (s.minX - scene.minX) / cellSize; x <= (s.maxX - scene.minX) / cellSize; x++) {
+				cellItems[cursor[y * columns + x]++] = i;
+			}
+		}
+	}
+	header.cellItemCount = (uint32_t)cellItems.size();
+
+	std::vector<uint8_t> buffer(sizeof(Header));
+	header.shapesOffset = align(buffer.size());
+	appendSection(buffer, header.shapesOffset, shapes.data(), shapes.size());
+	header.valuesOffset = align(buffer.size());
+	appendSection(buffer, header.valuesOffset, values.data(), values.size());
+	header.cellStartsOffset = align(buffer.size());
+	appendSection(buffer, header.cellStartsOffset, cellStarts.data(), cellStarts.size());
+	header.cellItemsOffset = align(buffer.size());
+	appendSection(buffer, header.cellItemsOffset, cellItems.data(), cellItems.size());
+	header.fileSize = buffer.size();
+	memcpy(buffer.data(), &header, sizeof(header));
+
+	HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	DWORD written = 0;
+	bool result = WriteFile(file, buffer.data(), (DWORD)buffer.size(), &written, nullptr) && written == buffer.size();
+	CloseHandle(file);
+	return result;
+}
+
+bool Snapshot::isSnapshot(const char* path) {
+	MappedFile file;
+	uint32_t magic = 0;
+	if (file.open(path) && file.getSize() >= sizeof(magic)) {
+		memcpy(&magic, file.begin(), sizeof(magic));
+	}
+	return magic == MAGIC;
+}
+
+bool Snapshot::View::open(const char* path) {
+	close();
+	if (!file.open(path) || file.getSize() < sizeof(Header)) {
+		close();
+		return false;
+	}
+	// The mapping is page aligned and every section 8 byte aligned, so the sections are read where they lie
+	const uint8_t* base = file.begin();
+	header = reinterpret_cast<const Header*>(base);
+	if (!validate()) {
+		close();
+		return false;
+	}
+	shapes = reinterpret_cast<const ShapeRecord*>(base + header->shapesOffset);
+	values = reinterpret_cast<const uint32_t*>(base + header->valuesOffset);
+	cellStarts = reinterpret_cast<const uint32_t*>(base + header->cellStartsOffset);
+	cellItems = reinterpret_cast<const uint32_t*>(base + header->cellItemsOffset);
+	if (!validateSections()) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void Snapshot::View::close() {
+	file.close();
+	header = nullptr;
+	shapes = nullptr;
+	values = nullptr;
+	cellStarts = nullptr;
+	cellItems = nullptr;
+}
+
+bool Snapshot::View::validate() const {
+	// The header and the section bounds, before any section is read
+	uint64_t size = file.getSize();
+	auto fits = [size](uint64_t offset, uint64_t count, uint64_t elementSize) {
+		return offset % 8 == 0 && offset <= size && count <= (size - offset) / elementSize;
+	};
+	uint64_t cellCount = (uint64_t)header->columns * header->rows;
+	return header->magic == MAGIC && header->version == VERSION && header->headerSize == sizeof(Header) && header->fileSize == size
+		&& header->cellSize > 0 && cellCount > 0 && cellCount <= MAX_CELLS
+		&& fits(header->shapesOffset, header->shapeCount, sizeof(ShapeRecord))
+		&& fits(header->valuesOffset, header->valueCount, sizeof(uint32_t))
+		&& fits(header->cellStartsOffset, cellCount + 1, sizeof(uint32_t))
+		&& fits(header->cellItemsOffset, header->cellItemCount, sizeof(uint32_t));
+}
+
+bool Snapshot::View::validateSections() const {
+	// One pass over the grid and the records, so that query and createGeometry can trust every index they follow
+	uint64_t cellCount = (uint64_t)header->columns * header->rows;
+	if (cellStarts[0] != 0 || cellStarts[cellCount] != header->cellItemCount) {
+		return false;
+	}
+	for (uint64_t i = 0; i < cellCount; i++) {
+		if (cellStarts[i] > cellStarts[i + 1]) {
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < header->cellItemCount; i++) {
+		if (cellItems[i] >= header->shapeCount) {
+			return false;
+		}
+	}
+	for (uint32_t i = 0; i < header->shapeCount; i++) {
+		const ShapeRecord& s = shapes[i];
+		if ((uint64_t)s.firstValue + s.valueCount > header->valueCount) {
+			return false;
+		}
+	}
+	return true;
+}
+
+BoundingBox Snapshot::View::getGridBounds() const {
+	if (!header) {
+		return BoundingBox();
+	}
+	uint64_t right = (uint64_t)header->originX + (uint64_t)header->columns * header->cellSize - 1;
+	uint64_t top = (uint64_t)header->originY + (uint64_t)header->rows * header->cellSize - 1;
+	return BoundingBox(header->originX, header->originY, (uint32_t)min(right, (uint64_t)UINT32_MAX), (uint32_t)min(top, (uint64_t)UINT32_MAX));
+}
+
+void Snapshot::View::getOccupiedCells(std::vector<BoundingBox>& cells) const {
+	if (!header) {
+		return;
+	}
+	for (uint32_t y = 0; y < header->rows; y++) {
+		for (uint32_t x = 0; x < header->columns; x++) {
+			uint32_t cell = y * header->columns + x;
+			if (cellStarts[cell] == cellStarts[cell + 1]) {
+				continue;
+			}
+			uint32_t left = header->originX + x * header->cellSize, bottom = header->originY + y * header->cellSize;
+			cells.push_back(BoundingBox(left, bottom, left + (header->cellSize - 1), bottom + (header->cellSize - 1)));
+		}
+	}
+}
+
+uint32_t Snapshot::View::cellColumn(uint32_t x) const {
+	if (x < header->originX) {
+		return 0;
+	}
+	return min((x - header->originX) / header->cellSize, header->columns - 1);
+}
+
+uint32_t Snapshot::View::cellRow(uint32_t y) const {
+	if (y < header->originY) {
+		return 0;
+	}
+	return min((y - header->originY) / header->cellSize, header->rows - 1);
+}
+
+void Snapshot::View::query(const BoundingBox& box, std::vector<uint32_t>& results) const {
+	if (!header || box.isEmpty()) {
+		return;
+	}
+	uint32_t firstColumn = cellColumn(box.minX), lastColumn = cellColumn(box.maxX);
+	uint32_t firstRow = cellRow(box.minY), lastRow = cellRow(box.maxY);
+	for (uint32_t y = firstRow; y <= lastRow; y++) {
+		for (uint32_t x = firstColumn; x <= lastColumn; x++) {
+			uint32_t cell = y * header->columns + x;
+			for (uint32_t i = cellStarts[cell]; i < cellStarts[cell + 1]; i++) {
+				const ShapeRecord& s = shapes[cellItems[i]];
+				if (!box.overlaps(BoundingBox(s.minX, s.minY, s.maxX, s.maxY))) {
+					continue;
+				}
+				// A shape spanning several cells is only reported from the first cell it shares with the query
+				if (x == max(cellColumn(s.minX), firstColumn) && y == max(cellRow(s.minY), firstRow)) {
+					results.push_back(cellItems[i]);
+				}
+			}
+		}
+	}
+}
+
+Geometry* Snapshot::View::createGeometry(uint32_t i, std::vector<Point2d>& points) const {
+	const ShapeRecord& s = shapes[i];
+	return Level::createGeometry(s.type, getValues(s), s.valueCount, points);
+}
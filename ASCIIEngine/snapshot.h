@@ -0,0 +1,87 @@
+#ifndef ASCIIENGINE_SNAPSHOT_H_
+#define ASCIIENGINE_SNAPSHOT_H_
+
+#include <stdint.h>
+#include <vector>
+#include "geometry.h"
+#include "mapped_file.h"
+
+// Scene store plus a prebuilt uniform grid over shape bounds, in one file that is used in place once mapped.
+// Every reference inside the file is a byte offset from its start, so the view works at any base address,
+// and every section is 8 byte aligned so it can be read through typed pointers
+namespace Snapshot {
+
+	const uint32_t MAGIC = 0x53435341; // "ASCS"
+	const uint16_t VERSION = 1;
+	const uint32_t DEFAULT_CELL_SIZE = 32;
+	const uint32_t MAX_CELLS = 1 << 20;
+
+	struct Header {
+		uint32_t magic;
+		uint16_t version;
+		uint16_t headerSize;
+		uint64_t fileSize;
+		uint32_t shapeCount;
+		uint32_t valueCount;
+		uint64_t shapesOffset; // ShapeRecord[shapeCount]
+		uint64_t valuesOffset; // uint32_t[valueCount], laid out as Level record values
+		// Grid in compressed sparse row form: the shapes overlapping cell i are cellItems[cellStarts[i], cellStarts[i + 1])
+		uint32_t originX, originY;
+		uint32_t cellSize;
+		uint32_t columns, rows;
+		uint32_t cellItemCount;
+		uint64_t cellStartsOffset; // uint32_t[columns * rows + 1]
+		uint64_t cellItemsOffset; // uint32_t[cellItemCount]
+	};
+
+	struct ShapeRecord {
+		uint8_t type; // Geometry::GeometryType
+		uint8_t reserved;
+		uint16_t valueCount;
+		uint32_t firstValue;
+		uint32_t minX, minY, maxX, maxY;
+	};
+
+	// Fails, writing nothing, if any shape cannot be stored as a level record
+	bool write(const char* path, const std::vector<Geometry*>& geometry, uint32_t cellSize = DEFAULT_CELL_SIZE);
+	bool isSnapshot(const char* path);
+
+	// Read only view over a mapped snapshot. Nothing is copied out of the file until a shape is materialized. Opening
+	// checks every reference the grid and records make, so queries and reads never index past a section
+	class View {
+
+	public:
+		bool open(const char* path);
+		void close();
+		bool isOpen() const { return header != nullptr; };
+
+		uint32_t getShapeCount() const { return header ? header->shapeCount : 0; };
+		const ShapeRecord& getShape(uint32_t i) const { return shapes[i]; };
+		const uint32_t* getValues(const ShapeRecord& s) const { return values + s.firstValue; };
+		static BoundingBox getBounds(const ShapeRecord& s) { return BoundingBox(s.minX, s.minY, s.maxX, s.maxY); };
+		// Area the grid's cells cover, holding the bounds of every shape
+		BoundingBox getGridBounds() const;
+		uint32_t getCellSize() const { return header ? header->cellSize : 0; };
+		// Bounds of every cell holding at least one shape
+		void getOccupiedCells(std::vector<BoundingBox>& cells) const;
+
+		// Indices of every shape whose bounds overlap box, each reported once
+		void query(const BoundingBox& box, std::vector<uint32_t>& results) const;
+		Geometry* createGeometry(uint32_t i, std::vector<Point2d>& points) const;
+
+	private:
+		MappedFile file;
+		const Header* header = nullptr;
+		const ShapeRecord* shapes = nullptr;
+		const uint32_t* values = nullptr;
+		const uint32_t* cellStarts = nullptr;
+		const uint32_t* cellItems = nullptr;
+
+		bool validate() const;
+		bool validateSections() const;
+		uint32_t cellColumn(uint32_t x) const;
+		uint32_t cellRow(uint32_t y) const;
+	};
+};
+
+#endif
@@ -0,0 +1,198 @@
+#include "snapshot_index.h"
+#include <algorithm>
+
+SnapshotIndex::SnapshotIndex(const Snapshot::View& p_view) : view(p_view) {
+	shapes.assign(view.getShapeCount(), nullptr);
+	failed.assign(view.getShapeCount(), false);
+	removed.assign(view.getShapeCount(), false);
+}
+
+SnapshotIndex::SnapshotIndex(const SnapshotIndex& other) : view(other.view), owner(false), shapes(other.shapes), records(other.records),
+	failed(other.failed), builtCount(other.builtCount), removed(other.removed), added(other.added), addedVersion(other.addedVersion), grid(other.grid) {
+}
+
+SnapshotIndex::~SnapshotIndex() {
+	if (owner) {
+		for (Geometry* g : shapes) {
+			delete g;
+		}
+	}
+}
+
+SpatialIndex* SnapshotIndex::clone() const {
+	for (uint32_t i = 0; i < shapes.size(); i++) {
+		shapeAt(i);
+	}
+	return new SnapshotIndex(*this);
+}
+
+Geometry* SnapshotIndex::shapeAt(uint32_t i) const {
+	if (shapes[i] || failed[i]) {
+		return shapes[i];
+	}
+	std::vector<Point2d> points;
+	shapes[i] = view.createGeometry(i, points);
+	if (!shapes[i]) {
+		failed[i] = true;
+		return nullptr;
+	}
+	records[shapes[i]] = i;
+	builtCount++;
+	return shapes[i];
+}
+
+template <typename Test>
+void SnapshotIndex::querySnapshot(const BoundingBox& box, Test test, std::vector<Geometry*>& results) const {
+	// The file's grid already reports each record once, so only removed records and the exact test are left to check
+	std::vector<uint32_t> found;
+	view.query(box, found);
+	for (uint32_t i : found) {
+		if (removed[i] || !test(Snapshot::View::getBounds(view.getShape(i)))) {
+			continue;
+		}
+		Geometry* g = shapeAt(i);
+		if (g) {
+			results.push_back(g);
+		}
+	}
+}
+
+void SnapshotIndex::addGeometry(Geometry* g) {
+	// A snapshot shape put back after being removed is found by its record again
+	auto it = records.find(g);
+	if (it != records.end()) {
+		removed[it->second] = false;
+		return;
+	}
+	added.addGeometry(g);
+}
+
+void SnapshotIndex::addGeometry(const std::vector<Geometry*>& geometry) {
+	for (Geometry* g : geometry) {
+		addGeometry(g);
+	}
+}
+
+void SnapshotIndex::removeGeometry(Geometry* g) {
+	// Snapshot shapes stay built, and owned by the index, since the caller may still hold them
+	auto it = records.find(g);
+	if (it != records.end()) {
+		removed[it->second] = true;
+		return;
+	}
+	added.removeGeometry(g);
+}
+
+void SnapshotIndex::removeGeometry(const std::vector<Geometry*>& geometry) {
+	for (Geometry* g : geometry) {
+		removeGeometry(g);
+	}
+}
+
+void SnapshotIndex::queryRect(const BoundingBox& box, std::vector<Geometry*>& results) const {
+	added.queryRect(box, results);
+	querySnapshot(box, [](const BoundingBox&) { return true; }, results);
+}
+
+void SnapshotIndex::querySegment(const Point2d& a, const Point2d& b, std::vector<Geometry*>& results) const {
+	added.querySegment(a, b, results);
+	BoundingBox box(min(a.x, b.x), min(a.y, b.y), max(a.x, b.x), max(a.y, b.y));
+	querySnapshot(box, [&a, &b](const BoundingBox& bounds) { return bounds.meetsSegment(a, b); }, results);
+}
+
+void SnapshotIndex::queryCircle(const Point2d& center, uint32_t radius, std::vector<Geometry*>& results) const {
+	added.queryCircle(center, radius, results);
+	double limit = (double)radius * radius;
+	BoundingBox box(center.x > radius ? center.x - radius : 0, center.y > radius ? center.y - radius : 0,
+		(uint32_t)min((uint64_t)center.x + radius, (uint64_t)UINT32_MAX), (uint32_t)min((uint64_t)center.y + radius, (uint64_t)UINT32_MAX));
+	querySnapshot(box, [&center, limit](const BoundingBox& bounds) { return bounds.distanceSquared(center) <= limit; }, results);
+}
+
+void SnapshotIndex::queryWedge(const Wedge& wedge, std::vector<Geometry*>& results) const {
+	added.queryWedge(wedge, results);
+	querySnapshot(wedge.getBounds(), [&wedge](const BoundingBox& bounds) { return wedge.meets(bounds); }, results);
+}
+
+void SnapshotIndex::nearest(const Point2d& p, uint32_t k, std::vector<Geometry*>& results) const {
+	if (k == 0) {
+		return;
+	}
+	std::vector<std::pair<double, Geometry*>> best; // Ascending by distance
+	std::vector<Geometry*> found;
+	added.nearest(p, k, found);
+	for (Geometry* g : found) {
+		best.push_back({ sqrt(g->bounds.distanceSquared(p)), g });
+	}
+
+	// Boxes around p doubling in size until they hold k records within their half width, as every record that close
+	// lies inside the box, or until they cover the whole grid. Only the records that make the k nearest are built
+	BoundingBox extent = view.getGridBounds();
+	std::vector<uint32_t> records;
+	std::vector<std::pair<double, uint32_t>> candidates;
+	for (uint64_t reach = max(view.getCellSize(), 1u); !extent.isEmpty(); reach *= 2) {
+		BoundingBox box((uint32_t)max((int64_t)p.x - (int64_t)reach, (int64_t)0), (uint32_t)max((int64_t)p.y - (int64_t)reach, (int64_t)0),
+			(uint32_t)min((uint64_t)p.x + reach, (uint64_t)UINT32_MAX), (uint32_t)min((uint64_t)p.y + reach, (uint64_t)UINT32_MAX));
+		records.clear();
+		view.query(box, records);
+		candidates.clear();
+		uint32_t within = 0;
+		for (uint32_t i : records) {
+			if (!removed[i] && !failed[i]) {
+				double distance = sqrt(Snapshot::View::getBounds(view.getShape(i)).distanceSquared(p));
+				candidates.push_back({ distance, i });
+				within += distance <= (double)reach;
+			}
+		}
+		if (within >= k || box.contains(extent)) {
+			break;
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+	uint32_t taken = 0;
+	for (const auto& c : candidates) {
+		if (taken == k) {
+			break;
+		}
+		Geometry* g = shapeAt(c.second);
+		if (g) {
+			best.push_back({ c.first, g });
+			taken++;
+		}
+	}
+
+	std::sort(best.begin(), best.end());
+	for (size_t i = 0; i < best.size() && i < k; i++) {
+		results.push_back(best[i].second);
+	}
+}
+
+const SnapshotIndex::Grid& SnapshotIndex::getGrid() {
+	const Grid& addedGrid = added.getGrid();
+	if (grid.version != 0 && addedGrid.version == addedVersion) {
+		return grid;
+	}
+	grid.horizontal.clear();
+	grid.vertical.clear();
+	std::vector<BoundingBox> cells;
+	view.getOccupiedCells(cells);
+	for (const BoundingBox& c : cells) {
+		grid.horizontal.push_back({ c.minY, c.minX, c.maxX });
+		grid.horizontal.push_back({ c.maxY, c.minX, c.maxX });
+		grid.vertical.push_back({ c.minX, c.minY, c.maxY });
+		grid.vertical.push_back({ c.maxX, c.minY, c.maxY });
+	}
+	grid.horizontal.insert(grid.horizontal.end(), addedGrid.horizontal.begin(), addedGrid.horizontal.end());
+	grid.vertical.insert(grid.vertical.end(), addedGrid.vertical.begin(), addedGrid.vertical.end());
+	addedVersion = addedGrid.version;
+	grid.version++;
+	return grid;
+}
+
+void SnapshotIndex::getSnapshotShapes(std::vector<Geometry*>& results) const {
+	for (uint32_t i = 0; i < shapes.size(); i++) {
+		Geometry* g = removed[i] ? nullptr : shapeAt(i);
+		if (g) {
+			results.push_back(g);
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#ifndef ASCIIENGINE_SNAPSHOT_INDEX_H_
+#define ASCIIENGINE_SNAPSHOT_INDEX_H_
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "geometry.h"
+#include "snapshot.h"
+#include "spatial_index.h"
+#include "uniform_grid.h"
+
+// Spatial index answered from a mapped snapshot's prebuilt grid, so a scene is queryable as soon as its file is open.
+// Queries are filtered on the record bounds in the file, and a shape is only built from its record the first time
+// a query reports it. Shapes added afterwards go to a uniform grid alongside. Unlike the other indexes this one owns
+// the shapes it builds, and the view must stay open for as long as the index or any clone of it is used
+class SnapshotIndex : public SpatialIndex {
+
+public:
+	SnapshotIndex(const Snapshot::View& p_view);
+	~SnapshotIndex();
+	SnapshotIndex& operator = (const SnapshotIndex&) = delete;
+	// Builds every shape first, so that the copy never writes to anything it shares. The copy owns none of them
+	SpatialIndex* clone() const;
+	Type getType() const { return SNAPSHOT; };
+
+	void addGeometry(Geometry* g);
+	void addGeometry(const std::vector<Geometry*>& geometry);
+	void removeGeometry(Geometry* g);
+	void removeGeometry(const std::vector<Geometry*>& geometry);
+	void queryRect(const BoundingBox& box, std::vector<Geometry*>& results) const;
+	void querySegment(const Point2d& a, const Point2d& b, std::vector<Geometry*>& results) const;
+	void queryCircle(const Point2d& center, uint32_t radius, std::vector<Geometry*>& results) const;
+	void queryWedge(const Wedge& wedge, std::vector<Geometry*>& results) const;
+	void nearest(const Point2d& p, uint32_t k, std::vector<Geometry*>& results) const;
+	// Occupied cells of the snapshot's grid, then those of the grid holding later shapes
+	const Grid& getGrid();
+
+	// Every shape still in the snapshot, building any not yet built. Shapes added later are not included
+	void getSnapshotShapes(std::vector<Geometry*>& results) const;
+	uint32_t getBuiltCount() const { return builtCount; };
+
+private:
+	SnapshotIndex(const SnapshotIndex& other);
+
+	// Shape of record i, built on first use. nullptr if it was removed or its record does not describe a shape
+	Geometry* shapeAt(uint32_t i) const;
+	// Appends the shape of every record whose bounds meet the box and pass test, each once
+	template <typename Test>
+	void querySnapshot(const BoundingBox& box, Test test, std::vector<Geometry*>& results) const;
+
+	const Snapshot::View& view;
+	bool owner = true; // Deletes the shapes it built
+	// Built lazily from const queries, so only the thread editing the index may query it until clone has built them all
+	mutable std::vector<Geometry*> shapes; // By record, nullptr until built
+	mutable std::unordered_map<Geometry*, uint32_t> records; // Record of each built shape, for removal
+	mutable std::vector<bool> failed; // Records that could not be built
+	mutable uint32_t builtCount = 0;
+	std::vector<bool> removed; // By record
+	UniformGrid added;
+	uint64_t addedVersion = 0; // Version of the added grid's spans in grid
+	Grid grid;
+};
+
+#endif
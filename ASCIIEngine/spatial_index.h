@@ -0,0 +1,48 @@
+#ifndef ASCIIENGINE_SPATIAL_INDEX_H_
+#define ASCIIENGINE_SPATIAL_INDEX_H_
+
+#include <stdint.h>
+#include <vector>
+#include "geometry.h"
+
+// Broad phase lookup of shapes by their bounds, implemented by the quadtree, the uniform grid and the snapshot index.
+// Shapes are held by pointer and never owned, except those the snapshot index builds from its records
+class SpatialIndex {
+
+public:
+	enum Type {
+		QUADTREE,
+		UNIFORM_GRID,
+		SNAPSHOT,
+
+		NUM_TYPES,
+	};
+
+	// Dividing lines of the index's cells, as flat runs of horizontal and vertical spans for drawing
+	struct Grid {
+		uint64_t version = 0; // Index version the spans were built from
+		std::vector<Span> horizontal;
+		std::vector<Span> vertical;
+	};
+
+	virtual ~SpatialIndex() {};
+	virtual SpatialIndex* clone() const = 0;
+	virtual Type getType() const = 0;
+
+	virtual void addGeometry(Geometry* g) = 0;
+	virtual void addGeometry(const std::vector<Geometry*>& geometry) = 0;
+	virtual void removeGeometry(Geometry* g) = 0;
+	virtual void removeGeometry(const std::vector<Geometry*>& geometry) = 0;
+	// Each query appends every shape whose bounds meet the region once, in no particular order, for the caller
+	// to run its exact test on. Shapes are indexed by their bounds, so a long wall is found wherever it passes
+	virtual void queryRect(const BoundingBox& box, std::vector<Geometry*>& results) const = 0;
+	virtual void querySegment(const Point2d& a, const Point2d& b, std::vector<Geometry*>& results) const = 0;
+	virtual void queryCircle(const Point2d& center, uint32_t radius, std::vector<Geometry*>& results) const = 0;
+	virtual void queryWedge(const Wedge& wedge, std::vector<Geometry*>& results) const = 0;
+	// Appends the k shapes whose bounds are closest to p, nearest first
+	virtual void nearest(const Point2d& p, uint32_t k, std::vector<Geometry*>& results) const = 0;
+	// Rebuilt only when the index has changed since the last call
+	virtual const Grid& getGrid() = 0;
+};
+
+#endif
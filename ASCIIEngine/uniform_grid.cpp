@@ -0,0 +1,398 @@
+#include "uniform_grid.h"
+#include <algorithm>
+
+UniformGrid::UniformGrid(uint32_t cellSize) {
+	shift = 0;
+	while (shift < 31 && (1u << shift) < cellSize) {
+		shift++;
+	}
+	cells.assign(MIN_CAPACITY, { 0, NONE, 0 });
+}
+
+uint32_t UniformGrid::home(uint64_t key) const {
+	// Fibonacci hashing, taking the well mixed high bits so that neighbouring cells spread across the table
+	return (uint32_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (uint32_t)(cells.size() - 1);
+}
+
+uint32_t UniformGrid::findCell(uint64_t key) const {
+	uint32_t mask = (uint32_t)cells.size() - 1;
+	for (uint32_t slot = home(key); cells[slot].count != 0; slot = (slot + 1) & mask) {
+		if (cells[slot].key == key) {
+			return slot;
+		}
+	}
+	return NONE;
+}
+
+uint32_t UniformGrid::insertCell(uint64_t key) {
+	// Kept at most half full so that probe runs stay short
+	if ((cellCount + 1) * 2 > cells.size()) {
+		rehash((uint32_t)cells.size() * 2);
+	}
+	uint32_t mask = (uint32_t)cells.size() - 1;
+	uint32_t slot = home(key);
+	for (; cells[slot].count != 0; slot = (slot + 1) & mask) {
+		if (cells[slot].key == key) {
+			return slot;
+		}
+	}
+	// The caller links a shape straight away, which marks the slot occupied
+	cells[slot] = { key, NONE, 0 };
+	cellCount++;
+	version++;
+	uint32_t x = (uint32_t)(key >> 32), y = (uint32_t)key;
+	extent = { min(extent.minX, x), min(extent.minY, y), max(extent.maxX, x), max(extent.maxY, y) };
+	return slot;
+}
+
+void UniformGrid::eraseCell(uint32_t slot) {
+	// Backward shift deletion. Later cells in the probe run move into the hole unless that would place them before
+	// their home slot, so lookups never need tombstones
+	uint32_t mask = (uint32_t)cells.size() - 1;
+	uint32_t hole = slot;
+	for (uint32_t i = (hole + 1) & mask; cells[i].count != 0; i = (i + 1) & mask) {
+		uint32_t h = home(cells[i].key);
+		if (((i - h) & mask) >= ((i - hole) & mask)) {
+			cells[hole] = cells[i];
+			hole = i;
+		}
+	}
+	cells[hole] = { 0, NONE, 0 };
+	cellCount--;
+	version++;
+	if (cellCount == 0) {
+		extent = { UINT32_MAX, UINT32_MAX, 0, 0 };
+	}
+}
+
+void UniformGrid::rehash(uint32_t newCapacity) {
+	std::vector<Cell> old(newCapacity, { 0, NONE, 0 });
+	old.swap(cells);
+	uint32_t mask = newCapacity - 1;
+	for (const Cell& c : old) {
+		if (c.count == 0) {
+			continue;
+		}
+		uint32_t slot = home(c.key);
+		while (cells[slot].count != 0) {
+			slot = (slot + 1) & mask;
+		}
+		cells[slot] = c;
+	}
+}
+
+UniformGrid::CellRange UniformGrid::rangeOf(const BoundingBox& b) const {
+	return { b.minX >> shift, b.minY >> shift, b.maxX >> shift, b.maxY >> shift };
+}
+
+void UniformGrid::link(uint64_t key, Geometry* g) {
+	uint32_t slot = insertCell(key);
+	uint32_t e;
+	if (freeEntries != NONE) {
+		e = freeEntries;
+		freeEntries = entries[e].next;
+	} else {
+		e = (uint32_t)entries.size();
+		entries.push_back(Entry());
+	}
+	entries[e] = { g, cells[slot].first };
+	cells[slot].first = e;
+	cells[slot].count++;
+}
+
+bool UniformGrid::unlink(uint32_t slot, Geometry* g) {
+	for (uint32_t* link = &cells[slot].first; *link != NONE; link = &entries[*link].next) {
+		if (entries[*link].g != g) {
+			continue;
+		}
+		uint32_t e = *link;
+		*link = entries[e].next;
+		entries[e] = { nullptr, freeEntries };
+		freeEntries = e;
+		if (--cells[slot].count == 0) {
+			eraseCell(slot);
+		}
+		return true;
+	}
+	return false;
+}
+
+template <typename Visit>
+void UniformGrid::forEachCell(const CellRange& range, Visit visit) const {
+	CellRange r = { max(range.minX, extent.minX), max(range.minY, extent.minY), min(range.maxX, extent.maxX), min(range.maxY, extent.maxY) };
+	if (r.minX > r.maxX || r.minY > r.maxY) {
+		return;
+	}
+	if (r.size() <= cells.size()) {
+		for (uint64_t x = r.minX; x <= r.maxX; x++) {
+			for (uint64_t y = r.minY; y <= r.maxY; y++) {
+				uint32_t slot = findCell(makeKey((uint32_t)x, (uint32_t)y));
+				if (slot != NONE) {
+					visit((uint32_t)x, (uint32_t)y, cells[slot]);
+				}
+			}
+		}
+		return;
+	}
+	for (const Cell& c : cells) {
+		uint32_t x = (uint32_t)(c.key >> 32), y = (uint32_t)c.key;
+		if (c.count != 0 && x >= r.minX && x <= r.maxX && y >= r.minY && y <= r.maxY) {
+			visit(x, y, c);
+		}
+	}
+}
+
+void UniformGrid::addGeometry(Geometry* g) {
+	CellRange r = rangeOf(g->bounds);
+	if (g->bounds.isEmpty() || r.size() > MAX_SHAPE_CELLS) {
+		oversized.push_back(g);
+		return;
+	}
+	for (uint64_t x = r.minX; x <= r.maxX; x++) {
+		for (uint64_t y = r.minY; y <= r.maxY; y++) {
+			link(makeKey((uint32_t)x, (uint32_t)y), g);
+		}
+	}
+}
+
+void UniformGrid::addGeometry(const std::vector<Geometry*>& geometry) {
+	for (Geometry* g : geometry) {
+		addGeometry(g);
+	}
+}
+
+void UniformGrid::removeGeometry(Geometry* g) {
+	CellRange r = rangeOf(g->bounds);
+	if (g->bounds.isEmpty() || r.size() > MAX_SHAPE_CELLS) {
+		auto it = std::find(oversized.begin(), oversized.end(), g);
+		if (it != oversized.end()) {
+			*it = oversized.back();
+			oversized.pop_back();
+		}
+		return;
+	}
+	for (uint64_t x = r.minX; x <= r.maxX; x++) {
+		for (uint64_t y = r.minY; y <= r.maxY; y++) {
+			uint32_t slot = findCell(makeKey((uint32_t)x, (uint32_t)y));
+			if (slot != NONE) {
+				unlink(slot, g);
+			}
+		}
+	}
+}
+
+void UniformGrid::removeGeometry(const std::vector<Geometry*>& geometry) {
+	for (Geometry* g : geometry) {
+		removeGeometry(g);
+	}
+}
+
+void UniformGrid::queryRect(const BoundingBox& box, std::vector<Geometry*>& results) const {
+	if (box.isEmpty()) {
+		return;
+	}
+	for (Geometry* g : oversized) {
+		if (box.overlaps(g->bounds)) {
+			results.push_back(g);
+		}
+	}
+	// A shape listed in several cells is reported only from the first cell it shares with the query, so no shape
+	// is appended twice and no visited set is needed
+	CellRange q = rangeOf(box);
+	forEachCell(q, [&](uint32_t x, uint32_t y, const Cell& c) {
+		for (uint32_t e = c.first; e != NONE; e = entries[e].next) {
+			const BoundingBox& b = entries[e].g->bounds;
+			if (box.overlaps(b) && max(b.minX >> shift, q.minX) == x && max(b.minY >> shift, q.minY) == y) {
+				results.push_back(entries[e].g);
+			}
+		}
+	});
+}
+
+void UniformGrid::querySegment(const Point2d& a, const Point2d& b, std::vector<Geometry*>& results) const {
+	for (Geometry* g : oversized) {
+		if (g->bounds.meetsSegment(a, b)) {
+			results.push_back(g);
+		}
+	}
+	if (cellCount == 0) {
+		return;
+	}
+	size_t begin = results.size();
+	// Column by column, covering the rows the segment spans across each. The column and row edges are widened
+	// slightly so that a segment running exactly along a cell border visits the cells on both sides
+	const Point2d& p0 = a.x <= b.x ? a : b;
+	const Point2d& p1 = a.x <= b.x ? b : a;
+	double dx = (double)p1.x - p0.x, dy = (double)p1.y - p0.y;
+	double lowest = min(p0.y, p1.y), highest = max(p0.y, p1.y);
+	uint32_t first = max(p0.x >> shift, extent.minX), last = min(p1.x >> shift, extent.maxX);
+	for (uint64_t cx = first; cx <= last; cx++) {
+		double left = max((double)p0.x, (double)(cx << shift)), right = min((double)p1.x, (double)((cx + 1) << shift));
+		double y0 = lowest, y1 = highest;
+		if (dx != 0) {
+			y0 = p0.y + (left - p0.x) * dy / dx;
+			y1 = p0.y + (right - p0.x) * dy / dx;
+		}
+		double bottom = max(lowest, min(y0, y1) - 1e-6), top = min(highest, max(y0, y1) + 1e-6);
+		uint32_t rowFirst = max((uint32_t)bottom >> shift, extent.minY), rowLast = min((uint32_t)top >> shift, extent.maxY);
+		for (uint64_t cy = rowFirst; cy <= rowLast; cy++) {
+			uint32_t slot = findCell(makeKey((uint32_t)cx, (uint32_t)cy));
+			if (slot == NONE) {
+				continue;
+			}
+			for (uint32_t e = cells[slot].first; e != NONE; e = entries[e].next) {
+				if (entries[e].g->bounds.meetsSegment(a, b)) {
+					results.push_back(entries[e].g);
+				}
+			}
+		}
+	}
+	// The cells a segment crosses are not a rectangle, so the first shared cell trick does not apply here
+	std::sort(results.begin() + begin, results.end());
+	results.erase(std::unique(results.begin() + begin, results.end()), results.end());
+}
+
+void UniformGrid::queryCircle(const Point2d& center, uint32_t radius, std::vector<Geometry*>& results) const {
+	double limit = (double)radius * radius;
+	for (Geometry* g : oversized) {
+		if (g->bounds.distanceSquared(center) <= limit) {
+			results.push_back(g);
+		}
+	}
+	// Every cell of the circle's bounds is visited, corners included, so the first shared cell trick still holds
+	BoundingBox box(center.x > radius ? center.x - radius : 0, center.y > radius ? center.y - radius : 0,
+		(uint32_t)min((uint64_t)center.x + radius, (uint64_t)UINT32_MAX), (uint32_t)min((uint64_t)center.y + radius, (uint64_t)UINT32_MAX));
+	CellRange q = rangeOf(box);
+	forEachCell(q, [&](uint32_t x, uint32_t y, const Cell& c) {
+		for (uint32_t e = c.first; e != NONE; e = entries[e].next) {
+			const BoundingBox& b = entries[e].g->bounds;
+			if (b.distanceSquared(center) <= limit && max(b.minX >> shift, q.minX) == x && max(b.minY >> shift, q.minY) == y) {
+				results.push_back(entries[e].g);
+			}
+		}
+	});
+}
+
+void UniformGrid::queryWedge(const Wedge& wedge, std::vector<Geometry*>& results) const {
+	for (Geometry* g : oversized) {
+		if (wedge.meets(g->bounds)) {
+			results.push_back(g);
+		}
+	}
+	// As with circles, every cell of the wedge's bounds is visited so the first shared cell trick holds
+	CellRange q = rangeOf(wedge.getBounds());
+	forEachCell(q, [&](uint32_t x, uint32_t y, const Cell& c) {
+		for (uint32_t e = c.first; e != NONE; e = entries[e].next) {
+			const BoundingBox& b = entries[e].g->bounds;
+			if (wedge.meets(b) && max(b.minX >> shift, q.minX) == x && max(b.minY >> shift, q.minY) == y) {
+				results.push_back(entries[e].g);
+			}
+		}
+	});
+}
+
+void UniformGrid::nearest(const Point2d& p, uint32_t k, std::vector<Geometry*>& results) const {
+	if (k == 0) {
+		return;
+	}
+	std::vector<std::pair<double, Geometry*>> best; // Ascending by distance, at most k long
+	auto offer = [&best, k, &p](Geometry* g) {
+		std::pair<double, Geometry*> candidate(sqrt(g->bounds.distanceSquared(p)), g);
+		best.insert(std::upper_bound(best.begin(), best.end(), candidate), candidate);
+		if (best.size() > k) {
+			best.pop_back();
+		}
+	};
+	for (Geometry* g : oversized) {
+		offer(g);
+	}
+	// Rings of cells outward from the one holding p. A shape is offered only from its cell nearest p's, the ring at
+	// which it is first reached, so once ring r is done every shape not yet offered is at least r cells away
+	int64_t px = p.x >> shift, py = p.y >> shift;
+	auto ringOf = [px, py](uint32_t x, uint32_t y) { return max(abs((int64_t)x - px), abs((int64_t)y - py)); };
+	auto visit = [&](uint32_t x, uint32_t y, const Cell& c) {
+		for (uint32_t e = c.first; e != NONE; e = entries[e].next) {
+			const BoundingBox& b = entries[e].g->bounds;
+			if (min(max((uint32_t)px, b.minX >> shift), b.maxX >> shift) == x && min(max((uint32_t)py, b.minY >> shift), b.maxY >> shift) == y) {
+				offer(entries[e].g);
+			}
+		}
+	};
+	auto visitCell = [&](int64_t x, int64_t y) {
+		if (x < extent.minX || x > extent.maxX || y < extent.minY || y > extent.maxY) {
+			return;
+		}
+		uint32_t slot = findCell(makeKey((uint32_t)x, (uint32_t)y));
+		if (slot != NONE) {
+			visit((uint32_t)x, (uint32_t)y, cells[slot]);
+		}
+	};
+	int64_t reach = max(max(px - extent.minX, (int64_t)extent.maxX - px), max(py - extent.minY, (int64_t)extent.maxY - py));
+	for (int64_t r = 0; cellCount != 0 && r <= reach; r++) {
+		if ((2 * r + 1) * (2 * r + 1) > (int64_t)cells.size()) {
+			// The rings so far have probed more cells than the table holds slots, as they do when p is far from every
+			// shape, so finish with one pass over every occupied cell not yet visited
+			for (const Cell& c : cells) {
+				uint32_t x = (uint32_t)(c.key >> 32), y = (uint32_t)c.key;
+				if (c.count != 0 && ringOf(x, y) >= r) {
+					visit(x, y, c);
+				}
+			}
+			break;
+		}
+		if (r == 0) {
+			visitCell(px, py);
+		} else {
+			for (int64_t x = px - r; x <= px + r; x++) {
+				visitCell(x, py - r);
+				visitCell(x, py + r);
+			}
+			for (int64_t y = py - r + 1; y <= py + r - 1; y++) {
+				visitCell(px - r, y);
+				visitCell(px + r, y);
+			}
+		}
+		if (best.size() == k && best.back().first <= (double)(r << shift)) {
+			break;
+		}
+	}
+	for (const auto& b : best) {
+		results.push_back(b.second);
+	}
+}
+
+const UniformGrid::Grid& UniformGrid::getGrid() {
+	if (grid.version == version) {
+		return grid;
+	}
+	grid.horizontal.clear();
+	grid.vertical.clear();
+	for (const Cell& c : cells) {
+		if (c.count == 0) {
+			continue;
+		}
+		uint32_t left = (uint32_t)(c.key >> 32) << shift, bottom = (uint32_t)c.key << shift;
+		uint32_t right = left + ((1u << shift) - 1), top = bottom + ((1u << shift) - 1);
+		grid.horizontal.push_back({ bottom, left, right });
+		grid.horizontal.push_back({ top, left, right });
+		grid.vertical.push_back({ left, bottom, top });
+		grid.vertical.push_back({ right, bottom, top });
+	}
+	grid.version = version;
+	return grid;
+}
+
+UniformGrid::Stats UniformGrid::getStats() const {
+	Stats stats;
+	stats.cells = cellCount;
+	stats.capacity = (uint32_t)cells.size();
+	stats.oversized = (uint32_t)oversized.size();
+	uint32_t mask = (uint32_t)cells.size() - 1;
+	for (uint32_t slot = 0; slot < cells.size(); slot++) {
+		if (cells[slot].count != 0) {
+			stats.entries += cells[slot].count;
+			stats.longestProbe = max(stats.longestProbe, ((slot - home(cells[slot].key)) & mask) + 1);
+		}
+	}
+	return stats;
+}
@@ -0,0 +1,95 @@
+#ifndef ASCIIENGINE_UNIFORM_GRID_H_
+#define ASCIIENGINE_UNIFORM_GRID_H_
+
+#include <stdint.h>
+#include <vector>
+#include "geometry.h"
+#include "spatial_index.h"
+
+// Spatial hash over square cells of one fixed size. Only occupied cells exist, kept in a flat open addressed table keyed
+// by cell coordinates, so a sparse world costs memory for what it holds rather than for its area. Each shape is listed
+// in every cell its bounds cover, which suits scenes of similarly sized shapes; shapes covering more than MAX_SHAPE_CELLS
+// cells are held once in a separate list that every query checks directly
+class UniformGrid : public SpatialIndex {
+
+public:
+	static constexpr uint32_t DEFAULT_CELL_SIZE = 64;
+	static constexpr uint32_t MAX_SHAPE_CELLS = 64;
+
+	struct Stats {
+		uint32_t cells = 0; // Occupied
+		uint32_t capacity = 0; // Table slots
+		uint32_t entries = 0; // Cell memberships across all shapes
+		uint32_t oversized = 0;
+		uint32_t longestProbe = 0;
+	};
+
+	// Cell size is rounded up to a power of two, so finding a cell is a shift
+	UniformGrid(uint32_t cellSize = DEFAULT_CELL_SIZE);
+	SpatialIndex* clone() const { return new UniformGrid(*this); };
+	Type getType() const { return UNIFORM_GRID; };
+
+	void addGeometry(Geometry* g);
+	void addGeometry(const std::vector<Geometry*>& geometry);
+	// Shapes are found again by their bounds, which must not have changed since they were added
+	void removeGeometry(Geometry* g);
+	void removeGeometry(const std::vector<Geometry*>& geometry);
+	void queryRect(const BoundingBox& box, std::vector<Geometry*>& results) const;
+	void querySegment(const Point2d& a, const Point2d& b, std::vector<Geometry*>& results) const;
+	void queryCircle(const Point2d& center, uint32_t radius, std::vector<Geometry*>& results) const;
+	void queryWedge(const Wedge& wedge, std::vector<Geometry*>& results) const;
+	void nearest(const Point2d& p, uint32_t k, std::vector<Geometry*>& results) const;
+	// Outlines of the occupied cells, rebuilt only when a cell has been filled or emptied since the last call
+	const Grid& getGrid();
+	uint32_t getCellSize() const { return 1u << shift; };
+	Stats getStats() const;
+
+private:
+	static constexpr uint32_t NONE = UINT32_MAX;
+	static constexpr uint32_t MIN_CAPACITY = 64;
+
+	// Table slot, empty while count is zero
+	struct Cell {
+		uint64_t key; // Column in the high half, row in the low
+		uint32_t first;
+		uint32_t count;
+	};
+
+	// Singly linked list node of a cell's shapes, pooled across all cells
+	struct Entry {
+		Geometry* g;
+		uint32_t next;
+	};
+
+	// Inclusive range of cell columns and rows
+	struct CellRange {
+		uint32_t minX, minY, maxX, maxY;
+
+		uint64_t size() const { return ((uint64_t)maxX - minX + 1) * ((uint64_t)maxY - minY + 1); };
+	};
+
+	static uint64_t makeKey(uint32_t x, uint32_t y) { return ((uint64_t)x << 32) | y; };
+	uint32_t home(uint64_t key) const;
+	uint32_t findCell(uint64_t key) const; // Slot holding key, or NONE
+	uint32_t insertCell(uint64_t key); // Slot holding key, claiming an empty one if it has none
+	void eraseCell(uint32_t slot);
+	void rehash(uint32_t newCapacity);
+	CellRange rangeOf(const BoundingBox& b) const;
+	void link(uint64_t key, Geometry* g);
+	bool unlink(uint32_t slot, Geometry* g);
+	// Calls visit(x, y, cell) for every occupied cell in range, walking the range or the table, whichever is smaller
+	template <typename Visit>
+	void forEachCell(const CellRange& range, Visit visit) const;
+
+	uint32_t shift;
+	std::vector<Cell> cells; // Power of two sized, probed linearly
+	uint32_t cellCount = 0;
+	std::vector<Entry> entries;
+	uint32_t freeEntries = NONE;
+	std::vector<Geometry*> oversized;
+	CellRange extent = { UINT32_MAX, UINT32_MAX, 0, 0 }; // Covers every occupied cell, though it only grows until the grid empties
+	uint64_t version = 1; // Advanced whenever a cell is filled or emptied
+	Grid grid;
+};
+
+#endif
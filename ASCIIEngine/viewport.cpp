@@ -0,0 +1,75 @@
+#include "viewport.h"
+
+void Viewport::setPanel(const Rect& p_panel) {
+	panel = p_panel;
+	panelCenterX = (panel.lt.x + panel.rb.x) / 2.0;
+	panelCenterY = (panel.lt.y + panel.rb.y) / 2.0;
+}
+
+void Viewport::pan(int32_t dx, int32_t dy) {
+	panX += dx / zoom;
+	panY += dy / zoom;
+}
+
+void Viewport::zoomBy(double factor) {
+	zoom = zoom * factor;
+	zoom = zoom < MIN_ZOOM ? MIN_ZOOM : (zoom > MAX_ZOOM ? MAX_ZOOM : zoom);
+}
+
+Point2d Viewport::toView(double x, double y) const {
+	double vx = panelCenterX + (x - centerX) * zoom + 0.5;
+	double vy = panelCenterY + (y - centerY) * zoom + 0.5;
+	return Point2d((uint32_t)(vx > 0 ? vx : 0), (uint32_t)(vy > 0 ? vy : 0));
+}
+
+Point2d Viewport::toWorld(const Point2d& p) const {
+	double wx = centerX + (p.x - panelCenterX) / zoom + 0.5;
+	double wy = centerY + (p.y - panelCenterY) / zoom + 0.5;
+	return Point2d((uint32_t)(wx > 0 ? wx : 0), (uint32_t)(wy > 0 ? wy : 0));
+}
+
+BoundingBox Viewport::getVisibleBounds() const {
+	double halfWidth = (panel.rb.x - panel.lt.x) / (2.0 * zoom);
+	double halfHeight = (panel.rb.y - panel.lt.y) / (2.0 * zoom);
+	double left = centerX - halfWidth, top = centerY - halfHeight;
+	double right = centerX + halfWidth, bottom = centerY + halfHeight;
+	if (right < 0 || bottom < 0) {
+		return BoundingBox();
+	}
+	return BoundingBox((uint32_t)(left > 0 ? left : 0), (uint32_t)(top > 0 ? top : 0), (uint32_t)right, (uint32_t)bottom);
+}
+
+bool Viewport::clip(double& ax, double& ay, double& bx, double& by) const {
+	// Liang-Barsky: narrow the parameter range [t0, t1] of a + t(b - a) against each side of the visible bounds
+	BoundingBox visible = getVisibleBounds();
+	if (visible.isEmpty()) {
+		return false;
+	}
+	double dx = bx - ax, dy = by - ay;
+	double p[4] = { -dx, dx, -dy, dy };
+	double q[4] = { ax - visible.minX, visible.maxX - ax, ay - visible.minY, visible.maxY - ay };
+	double t0 = 0, t1 = 1;
+	for (int i = 0; i < 4; i++) {
+		if (p[i] == 0) {
+			if (q[i] < 0) {
+				return false;
+			}
+			continue;
+		}
+		double t = q[i] / p[i];
+		if (p[i] < 0) {
+			t0 = t > t0 ? t : t0;
+		} else {
+			t1 = t < t1 ? t : t1;
+		}
+		if (t0 > t1) {
+			return false;
+		}
+	}
+	double x0 = ax + t0 * dx, y0 = ay + t0 * dy;
+	bx = ax + t1 * dx;
+	by = ay + t1 * dy;
+	ax = x0;
+	ay = y0;
+	return true;
+}
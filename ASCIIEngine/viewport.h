@@ -0,0 +1,42 @@
+#ifndef ASCIIENGINE_VIEWPORT_H_
+#define ASCIIENGINE_VIEWPORT_H_
+
+#include <stdint.h>
+#include "geometry.h"
+
+// World to view transform for the TOP_DOWN panel. The panel centre shows the followed camera plus a pan
+// offset, scaled by zoom screen pixels per world unit
+class Viewport {
+
+public:
+	static constexpr double MIN_ZOOM = 0.125;
+	static constexpr double MAX_ZOOM = 8.0;
+	static constexpr double ZOOM_STEP = 1.25;
+
+	double centerX = 0, centerY = 0; // World point drawn at the panel centre
+	double panX = 0, panY = 0; // World offset of the view from the followed camera
+	double zoom = 1.0;
+
+	Viewport() {};
+
+	void setPanel(const Rect& p_panel);
+	void follow(const Camera& c) { centerX = c.px + panX; centerY = c.py + panY; };
+	void pan(int32_t dx, int32_t dy); // in screen pixels
+	void zoomBy(double factor);
+	void reset() { panX = 0; panY = 0; zoom = 1.0; };
+
+	// View coordinates are rounded to the nearest pixel; world coordinates left or above the origin clamp to 0
+	Point2d toView(double x, double y) const;
+	Point2d toView(const Point2d& p) const { return toView((double)p.x, (double)p.y); };
+	Point2d toWorld(const Point2d& p) const;
+	BoundingBox getVisibleBounds() const;
+
+	// Clip world segment ab to the visible bounds, returning false if none of it is visible
+	bool clip(double& ax, double& ay, double& bx, double& by) const;
+
+private:
+	Rect panel;
+	double panelCenterX = 0, panelCenterY = 0;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#include "visible_set.h"
+#include <algorithm>
+#include <iterator>
+
+void VisibleSet::add(Geometry* g) {
+	positions[g] = (uint32_t)shapes.size();
+	shapes.push_back(g);
+	added.push_back(g);
+}
+
+void VisibleSet::remove(Geometry* g) {
+	auto it = positions.find(g);
+	uint32_t position = it->second;
+	positions.erase(it);
+	if (position + 1 != shapes.size()) {
+		shapes[position] = shapes.back();
+		positions[shapes[position]] = position;
+	}
+	shapes.pop_back();
+	removed.push_back(g);
+}
+
+void VisibleSet::update(const SpatialIndex& index, const Wedge& wedge) {
+	added.clear();
+	removed.clear();
+	uint16_t span = (wedge.to - wedge.from).value;
+	int32_t turn = wedge.from.differenceFrom(current.from);
+	rebuilt = !valid || wedge.apex != current.apex || wedge.reach != current.reach || span != (current.to - current.from).value || abs(turn) >= span;
+	if (rebuilt) {
+		found.clear();
+		index.queryWedge(wedge, found);
+		std::vector<Geometry*> previous = shapes;
+		std::sort(previous.begin(), previous.end());
+		std::sort(found.begin(), found.end());
+		std::vector<Geometry*> leaving;
+		std::set_difference(previous.begin(), previous.end(), found.begin(), found.end(), std::back_inserter(leaving));
+		for (Geometry* g : leaving) {
+			remove(g);
+		}
+		for (Geometry* g : found) {
+			if (!contains(g)) {
+				add(g);
+			}
+		}
+	} else if (turn != 0) {
+		// The slivers between each old edge and its new position. Only shapes meeting the one the view turned away
+		// from can have left it, and only those meeting the one it turned into can have entered
+		Wedge leaving = turn > 0 ? Wedge(wedge.apex, current.from, wedge.from, wedge.reach) : Wedge(wedge.apex, wedge.to, current.to, wedge.reach);
+		Wedge entering = turn > 0 ? Wedge(wedge.apex, current.to, wedge.to, wedge.reach) : Wedge(wedge.apex, wedge.from, current.from, wedge.reach);
+		found.clear();
+		index.queryWedge(leaving, found);
+		for (Geometry* g : found) {
+			if (contains(g) && !wedge.meets(g->bounds)) {
+				remove(g);
+			}
+		}
+		found.clear();
+		index.queryWedge(entering, found);
+		for (Geometry* g : found) {
+			if (!contains(g) && wedge.meets(g->bounds)) {
+				add(g);
+			}
+		}
+	}
+	current = wedge;
+	valid = true;
+}
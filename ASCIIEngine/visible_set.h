@@ -0,0 +1,40 @@
+#ifndef ASCIIENGINE_VISIBLE_SET_H_
+#define ASCIIENGINE_VISIBLE_SET_H_
+
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+#include "geometry.h"
+#include "spatial_index.h"
+
+// Shapes meeting the camera's view wedge, carried from frame to frame. While the camera only turns, by less than
+// its field of view, just the slivers swept past each edge of the wedge are queried: shapes are added from the one
+// the view turned into and dropped from the one it turned away from. Anything else queries the whole wedge again
+class VisibleSet {
+
+public:
+	// Rebuilds the set from the index on the first update and after a move, a change of reach or an invalidate
+	void update(const SpatialIndex& index, const Wedge& wedge);
+	void invalidate() { valid = false; }; // The index has been edited
+	const std::vector<Geometry*>& getShapes() const { return shapes; }; // In no particular order
+	bool contains(Geometry* g) const { return positions.count(g) != 0; };
+	// Changes made by the last update
+	const std::vector<Geometry*>& getAdded() const { return added; };
+	const std::vector<Geometry*>& getRemoved() const { return removed; };
+	bool wasRebuilt() const { return rebuilt; };
+
+private:
+	void add(Geometry* g);
+	void remove(Geometry* g);
+
+	std::vector<Geometry*> shapes;
+	std::unordered_map<Geometry*, uint32_t> positions; // Index of each shape in shapes, for removal by swapping with the last
+	std::vector<Geometry*> added;
+	std::vector<Geometry*> removed;
+	std::vector<Geometry*> found; // Reused query results
+	Wedge current;
+	bool valid = false;
+	bool rebuilt = false;
+};
+
+#endif